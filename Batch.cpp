@@ -0,0 +1,160 @@
+/**
+ * @file Batch.cpp
+ * @brief Plans many missions listed in a manifest file in one run.
+ * Each line of the manifest is the comma separated paths of a mission's mission, search grid, boundary
+ * points and output files. Blank lines and lines starting with # are ignored, and relative paths are
+ * taken relative to the manifest's directory. Missions are planned concurrently on the shared thread
+ * pool and a table of each one's runtime and path length is printed once they are all done.
+ * @see planMission
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "Mission.cpp"
+
+/**
+ * @brief A single mission in a batch.
+ */
+struct BatchJob
+{
+    /**
+     * @brief The batch's parameters with this mission's files.
+     */
+    PlannerConfig config;
+    /**
+     * @brief The outcome of planning the mission.
+     */
+    MissionResult result;
+    /**
+     * @brief Whether the mission was planned.
+     */
+    bool ok;
+
+    BatchJob(): ok(false)
+    {}
+};
+
+/**
+ * @brief Strip leading and trailing whitespace.
+ * @param s the string
+ * @return the trimmed string
+ */
+std::string trim(const std::string &s)
+{
+    std::string::size_type first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+        return "";
+    return s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+/**
+ * @brief Resolve a path relative to a directory.
+ * @param dir the directory, empty or ending in a separator
+ * @param path the path
+ * @return the path itself if it is absolute, else the path appended to the directory
+ */
+std::string resolvePath(const std::string &dir, const std::string &path)
+{
+    if (path.empty() || path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'))
+        return path;
+    return dir + path;
+}
+
+/**
+ * @brief Read the missions listed in a manifest file.
+ * @param path path of the manifest
+ * @param base the parameters shared by every mission
+ * @param jobs stores one job per mission in file order
+ * @return true if the manifest was read and every line was valid, else false
+ */
+bool readManifest(const std::string &path, const PlannerConfig &base, std::vector<BatchJob> &jobs)
+{
+    std::ifstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "Error: Could not open manifest file " << path << '\n';
+        return false;
+    }
+    std::string::size_type slash = path.find_last_of("/\\");
+    std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    std::string line;
+    unsigned int lineNum = 0;
+    jobs.clear();
+    while (std::getline(file, line))
+    {
+        ++lineNum;
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::vector<std::string> fields;
+        std::string::size_type begin = 0, comma;
+        while ((comma = line.find(',', begin)) != std::string::npos)
+        {
+            fields.push_back(trim(line.substr(begin, comma - begin)));
+            begin = comma + 1;
+        }
+        fields.push_back(trim(line.substr(begin)));
+        if (fields.size() != 4 || fields[0].empty() || fields[1].empty() || fields[2].empty() || fields[3].empty())
+        {
+            std::cout << "Error: Invalid manifest line " << lineNum << " in " << path << ": " << line << '\n';
+            return false;
+        }
+        BatchJob job;
+        job.config = base;
+        job.config.missionFile = resolvePath(dir, fields[0]);
+        job.config.searchFile = resolvePath(dir, fields[1]);
+        job.config.boundsFile = resolvePath(dir, fields[2]);
+        job.config.outFile = resolvePath(dir, fields[3]);
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+/**
+ * @brief Plan every mission listed in a manifest and print a summary table.
+ * Missions are spread over the shared thread pool, whose size is fixed by THREADS. The planner's own
+ * parallel loops run on the same pool so a large mission does not leave workers idle once the others finish.
+ * @param config the parameters shared by every mission. config.batchFile is the manifest
+ * @param naive true to use naive path generation with no decomposition
+ * @return true if every mission was planned, else false
+ * @see readManifest planMission THREADS
+ */
+bool runBatch(const PlannerConfig &config, bool naive)
+{
+    std::vector<BatchJob> jobs;
+    if (!readManifest(config.batchFile, config, jobs))
+        return false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    threadPool().parallelFor(jobs.size(), [&jobs, naive](unsigned int i)
+        { jobs[i].ok = planMission(jobs[i].config, naive, jobs[i].result); });
+    double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Print the summary
+    unsigned int failed = 0;
+    double busy = 0;
+    std::cout << std::left << std::setw(6) << "Job" << std::setw(8) << "Status" << std::right << std::setw(12) << "Time (ms)"
+              << std::setw(14) << "Length (m)" << std::setw(11) << "Waypoints" << "  Output\n";
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const MissionResult &result = jobs[i].result;
+        std::cout << std::left << std::setw(6) << i + 1 << std::setw(8) << (jobs[i].ok ? "ok" : "failed") << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << result.millis << std::setw(14) << result.pathLength
+                  << std::setw(11) << result.waypoints << "  " << jobs[i].config.outFile;
+        if (!jobs[i].ok)
+        {
+            std::cout << " (" << result.error << ")";
+            ++failed;
+        }
+        std::cout << '\n';
+        busy += result.millis;
+    }
+    std::cout << jobs.size() - failed << " of " << jobs.size() << " missions planned in " << wall << " ms ("
+              << busy << " ms of planning)\n";
+    return failed == 0;
+}
@@ -0,0 +1,444 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Benchmark driver for the search path planner.
+ * Compile separately from main.cpp (eg. g++ -O2 -pthread Benchmark.cpp -o benchmark).
+ * Run with no arguments or "traversal" to time the traversal solvers on random graphs.
+ * Run with "phases" and an optional seed to time each planning phase on generated search areas of growing size.
+ * Run with "width" and an optional seed and count to check getWidth() against getWidthNaive() on random polygons.
+ * It exits with a non-zero status if any polygon's width or chosen edge differs.
+ * Run with "memo" and an optional seed and count to replan generated search areas through a PlanMemo
+ * over a series of vertex edits. It exits with a non-zero status if a replan decomposes differently from
+ * a plan from scratch or the memo loses the entries of pieces the edits left unchanged.
+ * Results are printed to stdout as CSV.
+ * @author Harvey Lin
+ */
+
+#include "Polygon.cpp"
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdlib>
+
+/**
+ * @brief Fill a graph with weights resembling those produced by computeGraph().
+ * Node centers are scattered over a square field and each node is made adjacent to its nearest neighbors.
+ * @param g the graph to fill
+ * @param seed seed for the random number generator
+ * @see computeGraph
+ */
+void randomGraph(Graph<Node, float_type> &g, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float_type> dist(0, 1000);
+    std::vector<Coord> centers;
+    for (unsigned int i = 0; i < g.size(); ++i)
+        centers.push_back(Coord(dist(gen), dist(gen)));
+    for (unsigned int i = 0; i < g.size(); ++i)
+    {
+        for (unsigned int j = 0; j < g.size(); ++j)
+            g.setWeight(i, j, (i == j) ? 0 : INF + distance(centers[i], centers[j]));
+        // Make the three nearest nodes adjacent like neighboring subregions would be
+        std::vector<unsigned int> nearest;
+        for (unsigned int j = 0; j < g.size(); ++j)
+            if (j != i)
+                nearest.push_back(j);
+        std::sort(nearest.begin(), nearest.end(), [&](unsigned int a, unsigned int b)
+                  { return distance(centers[i], centers[a]) < distance(centers[i], centers[b]); });
+        for (unsigned int k = 0; k < nearest.size() && k < 3; ++k)
+        {
+            g.setEdge(i, nearest[k]);
+            g.setEdge(nearest[k], i);
+        }
+    }
+    for (unsigned int i = 0; i < g.size(); ++i)
+        for (unsigned int j = 0; j < g.size(); ++j)
+            if (g.hasEdge(i, j))
+                g.setWeight(i, j, distance(centers[i], centers[j]));
+}
+
+/**
+ * @brief Time a traversal solver on a graph.
+ * @param solver the traversal function to time
+ * @param g the weighted graph
+ * @param length stores the length of the resulting traversal
+ * @return the runtime in milliseconds
+ */
+double timeTraversal(std::list<unsigned int> (*solver)(Graph<Node, float_type>&), Graph<Node, float_type> &g, float_type &length)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::list<unsigned int> path = solver(g);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    length = traversalLength(g, path);
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Generate a random star-shaped polygon.
+ * Vertices are placed at evenly spaced angles around the origin with random radii.
+ * @param n number of vertices
+ * @param seed seed for the random number generator
+ * @return the polygon in CCW order
+ */
+Polygon starPolygon(unsigned int n, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float_type> radius(300, 1000);
+    std::uniform_real_distribution<float_type> jitter(-0.3, 0.3);
+    Polygon p;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        float_type theta = 2 * PI * (i + 0.5 + jitter(gen)) / n;
+        float_type r = radius(gen);
+        p.addVert(Coord(r * cos(theta), r * sin(theta)));
+    }
+    return p;
+}
+
+/**
+ * @brief Generate a comb polygon with a row of teeth along its top.
+ * Every tooth adds one concave vertex at the bottom of the notch between teeth.
+ * @param teeth number of teeth
+ * @param seed seed for the random number generator
+ * @return the polygon in CCW order
+ */
+Polygon combPolygon(unsigned int teeth, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float_type> tip(1400, 1600);
+    std::uniform_real_distribution<float_type> notch(400, 900);
+    const float_type toothWidth = 200;
+    const float_type length = teeth * toothWidth;
+    Polygon p;
+    p.addVert(Coord(0, 0));
+    p.addVert(Coord(length, 0));
+    for (unsigned int i = teeth; i > 0; --i) // Walk the top from right to left to stay CCW
+    {
+        p.addVert(Coord(i * toothWidth - 0.25 * toothWidth, tip(gen)));
+        if (i > 1)
+            p.addVert(Coord((i - 1) * toothWidth, notch(gen)));
+    }
+    p.addVert(Coord(0, tip(gen)));
+    return p;
+}
+
+/**
+ * @brief Generate a corridor that winds outward in a spiral.
+ * @param n number of samples along the centerline. The polygon has 2n vertices
+ * @param seed seed for the random number generator
+ * @return the polygon in CCW order
+ */
+Polygon spiralPolygon(unsigned int n, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float_type> jitter(-5, 5);
+    const float_type turns = 3;
+    const float_type pitch = 400; // Distance between neighboring loops of the centerline
+    const float_type halfWidth = 120; // Half the width of the corridor
+    std::vector<Coord> outer, inner;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        float_type theta = 2 * PI * turns * i / (n - 1);
+        float_type r = 300 + pitch * theta / (2 * PI);
+        outer.push_back(Coord((r + halfWidth + jitter(gen)) * cos(theta), (r + halfWidth + jitter(gen)) * sin(theta)));
+        inner.push_back(Coord((r - halfWidth + jitter(gen)) * cos(theta), (r - halfWidth + jitter(gen)) * sin(theta)));
+    }
+    Polygon p;
+    for (unsigned int i = 0; i < n; ++i) // Out along the outer wall and back along the inner wall
+        p.addVert(outer[i]);
+    for (unsigned int i = n; i > 0; --i)
+        p.addVert(inner[i - 1]);
+    return p;
+}
+
+/**
+ * @brief Generate a search area resembling an AUVSI competition field.
+ * A roughly 1.6 km by 0.8 km area with a few shallow notches cut into its sides.
+ * @param n number of vertices
+ * @param seed seed for the random number generator
+ * @return the polygon in CCW order
+ */
+Polygon fieldPolygon(unsigned int n, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float_type> scale(0.8, 1.0);
+    std::uniform_real_distribution<float_type> jitter(-0.2, 0.2);
+    Polygon p;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        float_type theta = 2 * PI * (i + 0.5 + jitter(gen)) / n;
+        float_type r = scale(gen);
+        p.addVert(Coord(800 * r * cos(theta), 400 * r * sin(theta)));
+    }
+    return p;
+}
+
+/**
+ * @brief Generate a random convex polygon.
+ * The polygon is the convex hull of random points, so it has no collinear vertices.
+ * @param n number of random points the hull is taken of
+ * @param seed seed for the random number generator
+ * @return the polygon in CCW order
+ */
+Polygon convexPolygon(unsigned int n, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float_type> dist(-1000, 1000);
+    std::vector<Coord> points;
+    for (unsigned int i = 0; i < n; ++i)
+        points.push_back(Coord(dist(gen), dist(gen)));
+    Polygon p;
+    convexHull(points, p.v);
+    return p;
+}
+
+/**
+ * @brief Generate a random star-shaped polygon with its vertices snapped to a coarse grid.
+ * Snapping makes collinear vertices, equal length spans and parallel edges common.
+ * @param n number of vertices
+ * @param seed seed for the random number generator
+ * @return the polygon in CCW order
+ */
+Polygon gridPolygon(unsigned int n, unsigned int seed)
+{
+    const float_type grid = 50;
+    Polygon p = starPolygon(n, seed);
+    for (unsigned int i = 0; i < p.size(); ++i)
+        p.v[i] = Coord(grid * round(p.v[i].x / grid), grid * round(p.v[i].y / grid));
+    p.invalidate();
+    return p;
+}
+
+/**
+ * @brief Time a single call.
+ * @param f the code to time
+ * @return the runtime in milliseconds
+ */
+template <typename F>
+double timeMs(F f)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Time each planning phase on a polygon and print the results as a CSV row.
+ * The phases run in the same order searchPath() runs them. pathTo() is timed from the first subregion
+ * to every other subregion with the polygon as its own boundary.
+ * @param name name of the generator
+ * @param n the size parameter passed to the generator
+ * @param p the polygon
+ */
+void timePhases(const std::string &name, unsigned int n, const Polygon &p)
+{
+    unsigned int numConcave = 0;
+    for (unsigned int i = 0; i < p.size(); ++i)
+        if (isConcave(p, i))
+            ++numConcave;
+    Polygon uncached(p); // getWidth caches its result so time it on a fresh copy
+    uncached.invalidate();
+    double widthMs = timeMs([&]() { getWidth(uncached); });
+    std::list<Polygon> subregions;
+    double decomposeMs = timeMs([&]() { decompose(p, subregions); });
+    double mergeMs = timeMs([&]() { mergeSubregions(subregions); });
+    Graph<Node, float_type> g(subregions.size());
+    unsigned int i = 0;
+    for (std::list<Polygon>::iterator it = subregions.begin(); it != subregions.end(); ++it)
+        g.v[i++].p = &(*it);
+    double traverseMs = timeMs([&]()
+                               {
+                                   for (unsigned int j = 0; j < g.size(); ++j)
+                                       traverse(*(g.v[j].p), g.v[j].path);
+                               });
+    double graphMs = timeMs([&]() { computeGraph(g); });
+    std::list<unsigned int> travOrder;
+    double minTraversalMs = timeMs([&]() { travOrder = minTraversal(g); });
+    double statesMs = timeMs([&]() { computeStates(travOrder, g); });
+    BoundaryIndex *index = NULL;
+    double indexMs = timeMs([&]() { index = new BoundaryIndex(p); });
+    std::vector<Coord> centers; // Vertex centroids, which lie inside the convex subregions
+    for (unsigned int j = 0; j < g.size(); ++j)
+    {
+        Coord c;
+        for (unsigned int k = 0; k < g.v[j].p->size(); ++k)
+            c = c + g.v[j].p->vert(k);
+        c = c * (1.0 / g.v[j].p->size());
+        if (inside(c, p)) // Only a self-intersecting subregion can be left concave
+            centers.push_back(c);
+    }
+    std::vector<Coord> transit;
+    double pathToMs = timeMs([&]()
+                             {
+                                 for (unsigned int j = 1; j < centers.size(); ++j)
+                                     pathTo(centers[0], centers[j], *index, transit);
+                             });
+    delete index;
+    double naivePathMs = timeMs([&]() { naivePath(p); });
+    std::cout << name << ',' << n << ',' << p.size() << ',' << numConcave << ',' << g.size() << ','
+              << widthMs << ',' << decomposeMs << ',' << mergeMs << ',' << traverseMs << ',' << graphMs << ','
+              << minTraversalMs << ',' << statesMs << ',' << indexMs << ',' << pathToMs << ',' << naivePathMs << '\n';
+}
+
+/**
+ * @brief Time the traversal solvers on random graphs of growing size.
+ */
+void traversalSuite()
+{
+    // Brute force is only timed while it still finishes in a reasonable amount of time
+    const unsigned int bruteForceLimit = 10;
+    std::cout << "nodes,bruteforce_ms,heldkarp_ms,greedy_ms,mintraversal_ms,greedy_excess\n";
+    for (unsigned int n = 4; n <= 20; ++n)
+    {
+        Graph<Node, float_type> g(n);
+        randomGraph(g, n);
+        float_type exactLength, greedyLength, length;
+        std::cout << n << ',';
+        if (n <= bruteForceLimit)
+            std::cout << timeTraversal(bruteForceTraversal, g, length);
+        std::cout << ',' << timeTraversal(heldKarpTraversal, g, exactLength);
+        std::cout << ',' << timeTraversal(greedyTraversal, g, greedyLength);
+        std::cout << ',' << timeTraversal(minTraversal, g, length);
+        std::cout << ',' << (greedyLength - exactLength) << '\n';
+    }
+}
+
+/**
+ * @brief Time every planning phase on each generated search area as its size grows.
+ * @param seed base seed for the generators. The same seed always produces the same polygons
+ */
+void phaseSuite(unsigned int seed)
+{
+    std::cout << "generator,n,vertices,concave,subregions,width_ms,decompose_ms,merge_ms,traverse_ms,graph_ms,"
+              << "mintraversal_ms,states_ms,boundaryindex_ms,pathto_ms,naivepath_ms\n";
+    for (unsigned int n = 8; n <= 128; n *= 2)
+        timePhases("star", n, starPolygon(n, seed + n));
+    for (unsigned int n = 4; n <= 64; n *= 2)
+        timePhases("comb", n, combPolygon(n, seed + n));
+    for (unsigned int n = 16; n <= 128; n *= 2)
+        timePhases("spiral", n, spiralPolygon(n, seed + n));
+    for (unsigned int n = 6; n <= 24; n += 6)
+        timePhases("field", n, fieldPolygon(n, seed + n));
+}
+
+/**
+ * @brief Check getWidth() against getWidthNaive() on random convex, star-shaped and grid-snapped polygons.
+ * Widths must agree to within a relative 1e-9, and the chosen edges must match unless another edge ties for the width.
+ * Prints one CSV row per mismatch and a summary row per generator.
+ * @param seed base seed for the generators. The same seed always produces the same polygons
+ * @param count number of polygons to check per generator
+ * @return true if every width and chosen edge matched, else false
+ */
+bool widthSuite(unsigned int seed, unsigned int count)
+{
+    const char *names[] = {"convex", "star", "grid"};
+    unsigned int failed = 0;
+    std::cout << "generator,seed,vertices,width,naive_width\n";
+    for (unsigned int kind = 0; kind < 3; ++kind)
+    {
+        unsigned int checked = 0, mismatched = 0;
+        for (unsigned int k = 0; k < count; ++k)
+        {
+            unsigned int polySeed = seed + k;
+            unsigned int n = 3 + polySeed % 62;
+            Polygon p = kind == 0 ? convexPolygon(n, polySeed) : kind == 1 ? starPolygon(n, polySeed) : gridPolygon(n, polySeed);
+            bool valid = p.size() >= 3 && !clockwise(p.v);
+            for (unsigned int i = 0; i < p.size() && valid; ++i) // Snapping can merge neighboring vertices
+                valid = !(p.v[i] == p.v[(i + 1) % p.size()]);
+            if (!valid)
+                continue;
+            ++checked;
+            Span width = getWidth(p);
+            Span naive = getWidthNaive(p);
+            // Vertices tied for farthest from an edge, and parallel edges tied for the width, can come out a rounding
+            // error apart, so a different edge is only a mismatch if its own width is not the minimum
+            float_type tolerance = 1e-9 * naive.length();
+            float_type edgeWidth = 0; // Distance from the chosen edge to the farthest vertex
+            for (unsigned int i = 0; i < p.size(); ++i)
+                edgeWidth = std::max(edgeWidth, distance(p.v[i], width.e));
+            if (std::abs(width.length() - naive.length()) > tolerance ||
+                (!(width.e == naive.e) && std::abs(edgeWidth - naive.length()) > tolerance))
+            {
+                ++mismatched;
+                std::cout << names[kind] << ',' << polySeed << ',' << p.size() << ',' << width.length() << ',' << naive.length() << '\n';
+            }
+        }
+        std::cout << names[kind] << " checked " << checked << " polygons, " << mismatched << " mismatched\n";
+        failed += mismatched;
+    }
+    return failed == 0;
+}
+
+/**
+ * @brief Replan generated search areas through a PlanMemo while moving one vertex at a time.
+ * After every edit the memo's decomposition must match decompose() without a memo, and every piece the
+ * memo holds must still hold the halves it was split into so the next edit can reuse them.
+ * Prints one CSV row per edit.
+ * @param seed base seed for the generators and the edits
+ * @param count number of edits per search area
+ * @return true if every replan matched and kept its pieces, else false
+ */
+bool memoSuite(unsigned int seed, unsigned int count)
+{
+    const char *names[] = {"star", "comb", "spiral", "field"};
+    PlannerConfig config;
+    unsigned int failed = 0;
+    std::cout << "generator,seed,edit,subregions,reused,matched,complete\n";
+    for (unsigned int kind = 0; kind < 4; ++kind)
+    {
+        for (unsigned int k = 0; k < 4; ++k)
+        {
+            unsigned int polySeed = seed + k;
+            Polygon p = kind == 0 ? starPolygon(24, polySeed) : kind == 1 ? combPolygon(6, polySeed) :
+                        kind == 2 ? spiralPolygon(16, polySeed) : fieldPolygon(16, polySeed);
+            std::mt19937 gen(polySeed);
+            std::uniform_real_distribution<float_type> nudge(-5, 5);
+            PlanMemo memo;
+            for (unsigned int edit = 0; edit <= count; ++edit)
+            {
+                if (edit > 0) // Nudge one vertex like an operator adjusting the search area
+                {
+                    unsigned int i = gen() % p.size();
+                    p.v[i] = Coord(p.v[i].x + nudge(gen), p.v[i].y + nudge(gen));
+                    p.invalidate();
+                }
+                std::list<Polygon> replanned, fresh;
+                memo.begin(config);
+                decompose(p, replanned, &memo);
+                decompose(p, fresh);
+                bool matched = replanned.size() == fresh.size();
+                for (std::list<Polygon>::iterator a = replanned.begin(), b = fresh.begin(); matched && a != replanned.end(); ++a, ++b)
+                    matched = a->v == b->v;
+                bool complete = true;
+                for (PlanMemo::DecompositionMap::iterator it = memo.decompositions.begin(); it != memo.decompositions.end(); ++it)
+                    for (size_t h = 0; h < it->second.halves.size(); ++h)
+                        complete = complete && memo.decompositions.count(it->second.halves[h]) > 0;
+                if (!matched || !complete)
+                    ++failed;
+                std::cout << names[kind] << ',' << polySeed << ',' << edit << ',' << fresh.size() << ',' << memo.reused
+                          << ',' << matched << ',' << complete << '\n';
+            }
+        }
+    }
+    return failed == 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string suite = (argc > 1) ? argv[1] : "traversal";
+    if (suite == "traversal")
+        traversalSuite();
+    else if (suite == "phases")
+        phaseSuite((argc > 2) ? (unsigned int)atoi(argv[2]) : 1);
+    else if (suite == "width")
+        return widthSuite((argc > 2) ? (unsigned int)atoi(argv[2]) : 1, (argc > 3) ? (unsigned int)atoi(argv[3]) : 2000) ? 0 : 1;
+    else if (suite == "memo")
+        return memoSuite((argc > 2) ? (unsigned int)atoi(argv[2]) : 1, (argc > 3) ? (unsigned int)atoi(argv[3]) : 10) ? 0 : 1;
+    else
+    {
+        std::cout << "Error: Invalid argument passed\n";
+        std::cout << "Available options: traversal, phases [seed], width [seed] [count], memo [seed] [count]\n";
+        return 1;
+    }
+    return 0;
+}
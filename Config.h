@@ -3,7 +3,9 @@
  * @author Harvey Lin
  * @brief Configuration header.
  * This file contains declarations used to configure the behavior of the program.
+ * The file paths, altitude, radius, offset, and correction are defaults for PlannerConfig and can be overridden at runtime.
  */
+#pragma once
 
 /**
  * @brief The resulting search path will be written to this file.
@@ -39,9 +41,52 @@
  */
 #define CORRECTION RADIUS
 /**
- * Max number of characters for lines read from mission files.
+ * Subregion graphs with at most this many nodes are ordered by brute force permutation.
  */
-#define BUFF_MAX 30
+#define BRUTE_FORCE_MAX 5
+/**
+ * Subregion graphs with at most this many nodes are ordered with the Held-Karp dynamic program.
+ * Memory use grows as 2^n * n so keep this modest. Larger graphs fall back to a greedy heuristic.
+ * @see BRUTE_FORCE_MAX
+ */
+#define HELD_KARP_MAX 16
+static_assert(HELD_KARP_MAX < 32, "Held-Karp indexes visited sets with 32-bit masks and stores parent nodes in an unsigned char");
+/**
+ * Subregion graphs with at most this many nodes have their order and start states optimized together.
+ * Memory use grows as 2^n * 4n. Larger graphs fix the order first and then optimize the start states.
+ */
+#define JOINT_TRAVERSAL_MAX 14
+static_assert(JOINT_TRAVERSAL_MAX * 4 <= 256, "The joint traversal stores each parent (node, state) pair packed in an unsigned char");
+/**
+ * Number of worker threads used by the planner. 0 uses one less than the number of hardware threads.
+ */
+#define THREADS 0
+/**
+ * Minimum number of candidate splits in a decomposition step before they are scored in parallel.
+ */
+#define PARALLEL_MIN_CANDIDATES 64
+/**
+ * Minimum number of vertices in a polygon before its two halves are decomposed in parallel.
+ */
+#define PARALLEL_MIN_VERTICES 16
+/**
+ * Number of boundary indexes and number of planned search paths the planning daemon keeps between requests.
+ */
+#define DAEMON_CACHE_SIZE 8
+/**
+ * Largest request in bytes the planning daemon reads. Longer requests are answered with an error and the connection is closed.
+ */
+#define DAEMON_MAX_REQUEST (1 << 20)
+/**
+ * Seconds the planning daemon waits on a connection that sends nothing or reads nothing before closing it.
+ */
+#define DAEMON_IDLE_TIMEOUT 30
+/**
+ * Set to 1 to compile in the phase timers and counters used for the profile report. Can also be set with -DPROFILE=1.
+ */
+#ifndef PROFILE
+#define PROFILE 0
+#endif
 /**
  * Epsilon value for the float type we are using.
  */
@@ -8,47 +8,24 @@
 #pragma once
 #include "Polygon.cpp"
 #include <vector>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #define EARTH_RADIUS 6378137 // Radius of the Earth in meters
 
 //================================================================
-// Prototypes, Constants, and Global Variables for
+// Prototypes and Constants for
 // GPS to Cartesian conversion
 //================================================================
-/**
- * @brief Initialize global reference vectors used for basis vector conversion from an anchor coordinate.
- * Call this before anything else.
- * @param longitude the longitude of the anchor coordinate in radians
- * @param latitude the latitude of the anchor coordinate in radians
- */
-void init(float_type longitude, float_type latitude);
 /**
  * @brief Converts GPS longitude and latitude to 3D Cartesian coordinates with standard basis vectors.
  * Origin is at the center of the Earth
  * @param longitude the longitude of the coordinate in radians
  * @param latitude the latitude of the coordinate in radians
+ * @param cart stores the X, Y and Z coordinates
  */
-std::vector<float_type> GPStoCartesian(const float_type longitude, const float_type latitude);
-/**
- * @brief Converts GPS longitude and latitude to 2D Cartesian coordinates measured in meters.
- * @param longitude the longitude of the coordinate in radians
- * @param latitude the latitude of the coordinate in radians
- * @return equivalent 2D coordinate
- * @see Coord
- */
-Coord GPStoCoord(const float_type longitude, const float_type latitude); // Converts GPS longitude and latitude to Cartesian coordinates measured in meters.
-/**
- * @brief Converts a 2D coordinate back to GPS longitude and latitude.
- * @param c coordinate to convert
- * @param longitude stores the resulting longitude
- * @param latitude stores the resulting latitude
- * @return resulting longitude is stored in longitude, latitude is stored in latitude
- */
-void CoordtoGPS(const Coord &c, float_type &longitude, float_type &latitude); // Converts a coordinate in our Cartesian system to GPS longitude and latitude
-/**
- * @brief Compute the basis vectors for our Cartesian system. Make sure this is run after init at the start of main.
- * @see init
- */
-inline void computeBasis(); // Compute the basis vectors for our Cartesian system. Make sure this is run at the start of main.
+inline void GPStoCartesian(const float_type longitude, const float_type latitude, float_type cart[3]);
 /**
  * @brief Convert degrees to radians.
  * @param degrees degrees to convert
@@ -82,143 +59,261 @@ inline float_type toFeet(float_type meters); // Convert meters to feet
  * @brief Indeces used to store X, Y, and Z coordinates in a vector.
  */
 enum {X = 0, Y = 1, Z = 2};
-namespace conv // Global constants used to keep function calls simple
+
+//================================================================
+// Structs
+//================================================================
+/**
+ * @brief A 2D Cartesian system on the plane tangent to the Earth at an anchor coordinate.
+ * Everything is computed by the constructor and every conversion is const, so one frame can be
+ * shared between threads and frames with different anchors can be used side by side.
+ */
+struct LocalFrame
 {
+    /**
+     * @brief Longitude of GPS coordinate used as the origin of the system in radians.
+     */
+    float_type refLong;
+    /**
+     * @brief Latitude of GPS coordinate used as the origin of the system in radians.
+     */
+    float_type refLat;
     /**
      * @brief GPS reference point in standard basis 3D Cartesian coordinates.
      */
-    std::vector<float_type> refCart;
+    float_type refCart[3];
     /**
-     * @brief Basis vectors for our cartesian system.
+     * @brief Basis vectors for the system.
      */
-    std::vector<float_type> ourX(3), ourY(3), ourZ(3);
+    float_type ourX[3], ourY[3], ourZ[3];
     /**
      * @brief Conversion matrix from standard basis to our basis.
      */
-    float_type convMatrix[3][3] = {};
+    float_type convMatrix[3][3];
+
     /**
-     * @brief Longitude of GPS coordinate used as the origin of our Cartesian system in radians.
+     * @brief Build the frame anchored at a GPS coordinate.
+     * @param longitude the longitude of the anchor coordinate in radians
+     * @param latitude the latitude of the anchor coordinate in radians
      */
-    float_type REF_LONG = 0;
+    LocalFrame(float_type longitude = 0, float_type latitude = 0);
     /**
-     * @brief Latitude of GPS coordinate used as the origin of our Cartesian system in radians.
+     * @brief Converts GPS longitude and latitude to 2D Cartesian coordinates measured in meters.
+     * @param longitude the longitude of the coordinate in radians
+     * @param latitude the latitude of the coordinate in radians
+     * @return equivalent 2D coordinate
+     * @see Coord
      */
-    float_type REF_LAT = 0;
-}
+    Coord toCoord(const float_type longitude, const float_type latitude) const;
+    /**
+     * @brief Converts a 2D coordinate back to GPS longitude and latitude.
+     * @param c coordinate to convert
+     * @param longitude stores the resulting longitude
+     * @param latitude stores the resulting latitude
+     * @return resulting longitude is stored in longitude, latitude is stored in latitude
+     */
+    void toGPS(const Coord &c, float_type &longitude, float_type &latitude) const;
+    /**
+     * @brief Converts arrays of GPS longitudes and latitudes to 2D coordinates.
+     * The linear part of the transform is done four points at a time with AVX2 when it is enabled at compile time.
+     * @param longitude the longitudes in radians
+     * @param latitude the latitudes in radians
+     * @param n the number of points
+     * @param out stores the n resulting coordinates
+     * @see toCoord
+     */
+    void toCoordBatch(const float_type *longitude, const float_type *latitude, size_t n, Coord *out) const;
+    /**
+     * @brief Converts an array of 2D coordinates back to GPS longitudes and latitudes.
+     * The linear part of the transform is done four points at a time with AVX2 when it is enabled at compile time.
+     * @param c the coordinates to convert
+     * @param n the number of coordinates
+     * @param longitude stores the n resulting longitudes in radians
+     * @param latitude stores the n resulting latitudes in radians
+     * @see toGPS
+     */
+    void toGPSBatch(const Coord *c, size_t n, float_type *longitude, float_type *latitude) const;
+};
 
 //================================================================
 // Definitions
 //================================================================
-void init(float_type longitude, float_type latitude)
-{
-    conv::REF_LONG = longitude;
-    conv::REF_LAT = latitude;
-    conv::refCart = GPStoCartesian(conv::REF_LONG, conv::REF_LAT);
-}
-
-std::vector<float_type> GPStoCartesian(const float_type longitude, const float_type latitude) // Converts GPS to 3D Cartesian coordinates with standard basis vectors
+inline void GPStoCartesian(const float_type longitude, const float_type latitude, float_type cart[3]) // Converts GPS to 3D Cartesian coordinates with standard basis vectors
 { // IMPORTANT: Assumes longitude and latitude are given in radians
     // Reference: https://en.wikipedia.org/wiki/Geographic_coordinate_conversion#From_geodetic_to_ECEF_coordinates
-    std::vector<float_type> coord;
-    coord.push_back(EARTH_RADIUS * cos(latitude) * cos(longitude)); // x coordinate
-    coord.push_back(EARTH_RADIUS * cos(latitude) * sin(longitude)); // y coordinate
-    coord.push_back(EARTH_RADIUS * sin(latitude)); // z coordinate
-    return coord;
- }
+    float_type cosLat = cos(latitude);
+    cart[X] = EARTH_RADIUS * cosLat * cos(longitude);
+    cart[Y] = EARTH_RADIUS * cosLat * sin(longitude);
+    cart[Z] = EARTH_RADIUS * sin(latitude);
+}
+
+LocalFrame::LocalFrame(float_type longitude, float_type latitude): refLong(longitude), refLat(latitude) // Compute our basis vectors based on the given reference point
+{
+    GPStoCartesian(refLong, refLat, refCart);
+    // Compute our Z basis vector
+    for (unsigned int i = 0; i < 3; ++i)
+	ourZ[i] = refCart[i];
+    float_type length = sqrt(ourZ[X] * ourZ[X] + ourZ[Y] * ourZ[Y] + ourZ[Z] * ourZ[Z]);
+    // Compute our X basis vector using equation of the plane at reference point
+    ourX[X] = (1.0);
+    ourX[Y] = (0);
+    ourX[Z] = ((ourZ[X] * refCart[X] - ourZ[X] * ourX[X] + ourZ[Y] * refCart[Y] - ourZ[Y] * ourX[Y] + ourZ[Z] * refCart[Z]) / ourZ[Z]);
+    // Make our X the positional vector anchored at refCart and pointing towards the point we just calculated on the plane
+    ourX[X] -= refCart[X];
+    ourX[Y] -= refCart[Y];
+    ourX[Z] -= refCart[Z];
+    // Cross our X and our Z to get our Y
+    ourY[X] = (ourZ[Y] * ourX[Z] - ourZ[Z] * ourX[Y]);
+    ourY[Y] = (-(ourZ[X] * ourX[Z] - ourZ[Z] * ourX[X]));
+    ourY[Z] = (ourZ[X] * ourX[Y] - ourZ[Y] * ourX[X]);
+    // Scale basis vectors to unit length
+    for (unsigned int i = 0; i < 3; ++i)
+	ourZ[i] /= length;
+    length = sqrt(ourX[X] * ourX[X] + ourX[Y] * ourX[Y] + ourX[Z] * ourX[Z]);
+    for (unsigned int i = 0; i < 3; ++i)
+	ourX[i] /= length;
+    length = sqrt(ourY[X] * ourY[X] + ourY[Y] * ourY[Y] + ourY[Z] * ourY[Z]);
+    for (unsigned int i = 0; i < 3; ++i)
+	ourY[i] /= length;
+    // Compute the conversion matrix by inverting the standard matrix
+    float_type standardMatrix[3][3] =
+	{
+	    {ourX[X], ourY[X], ourZ[X]},
+	    {ourX[Y], ourY[Y], ourZ[Y]},
+	    {ourX[Z], ourY[Z], ourZ[Z]}
+	};
+    float_type determinate = (standardMatrix[0][0] * (standardMatrix[1][1] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][1])) -
+	(standardMatrix[0][1] * (standardMatrix[1][0] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][0])) +
+	(standardMatrix[0][2] * (standardMatrix[1][0] * standardMatrix[2][1] - standardMatrix[1][1] * standardMatrix[2][0]));
+    for (unsigned int i = 0; i < 3; ++i) // Transpose the standard matrix
+	for (unsigned int j = i; j < 3; ++j)
+	    std::swap(standardMatrix[i][j], standardMatrix[j][i]);
+    convMatrix[0][0] = standardMatrix[1][1] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][1];
+    convMatrix[0][1] = standardMatrix[1][0] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][0];
+    convMatrix[0][2] = standardMatrix[1][0] * standardMatrix[2][1] - standardMatrix[1][1] * standardMatrix[2][0];
+    convMatrix[1][0] = standardMatrix[0][1] * standardMatrix[2][2] - standardMatrix[0][2] * standardMatrix[2][1];
+    convMatrix[1][1] = standardMatrix[0][0] * standardMatrix[2][2] - standardMatrix[0][2] * standardMatrix[2][0];
+    convMatrix[1][2] = standardMatrix[0][0] * standardMatrix[2][1] - standardMatrix[0][1] * standardMatrix[2][0];
+    convMatrix[2][0] = standardMatrix[0][1] * standardMatrix[1][2] - standardMatrix[0][2] * standardMatrix[1][1];
+    convMatrix[2][1] = standardMatrix[0][0] * standardMatrix[1][2] - standardMatrix[0][2] * standardMatrix[1][0];
+    convMatrix[2][2] = standardMatrix[0][0] * standardMatrix[1][1] - standardMatrix[0][1] * standardMatrix[1][0];
+    for (unsigned int i = 0; i < 3; ++i)
+	for (unsigned int j = 0; j < 3; ++j)
+	    convMatrix[i][j] /= determinate;
+    convMatrix[0][1] *= -1;
+    convMatrix[1][0] *= -1;
+    convMatrix[1][2] *= -1;
+    convMatrix[2][1] *= -1;
+}
 
-Coord GPStoCoord(const float_type longitude, const float_type latitude) // Converts GPS long and alt to Cartesian coordinates measured in meters
+Coord LocalFrame::toCoord(const float_type longitude, const float_type latitude) const // Converts GPS long and alt to Cartesian coordinates measured in meters
 {
     // Reference: https://stackoverflow.com/questions/1185408/converting-from-longitude-latitude-to-cartesian-coordinates#1185413
     // Right multiply the GPS coordinate converted to standard basis Cartesian with the conversion matrix constructed from our new basis vectors
-    std::vector<float_type> standardCart = GPStoCartesian(longitude, latitude); // The coordinate with standard basis vectors
+    float_type standardCart[3]; // The coordinate with standard basis vectors
+    GPStoCartesian(longitude, latitude, standardCart);
     Coord result;
     result.x = result.y = 0;
     // Shift so that our reference coordinate is the origin
     // std::cout << "GPS Cartesian (before shift): " << standardCart[X] << ", " << standardCart[Y] << ", " << standardCart[Z] << '\n';
-    standardCart[X] -= conv::refCart[X];
-    standardCart[Y] -= conv::refCart[Y];
-    standardCart[Z] -= conv::refCart[Z];
+    standardCart[X] -= refCart[X];
+    standardCart[Y] -= refCart[Y];
+    standardCart[Z] -= refCart[Z];
     // Convert to our basis vectors
     // Because of how we defined our basis vectors, we should be able to disregard the resulting Z-coordinate since it will be approximately 0
-    result.x = conv::convMatrix[0][0] * standardCart[X] + conv::convMatrix[0][1] * standardCart[Y] + conv::convMatrix[0][2] * standardCart[Z];
-    result.y = conv::convMatrix[1][0] * standardCart[X] + conv::convMatrix[1][1] * standardCart[Y] + conv::convMatrix[1][2] * standardCart[Z];
+    result.x = convMatrix[0][0] * standardCart[X] + convMatrix[0][1] * standardCart[Y] + convMatrix[0][2] * standardCart[Z];
+    result.y = convMatrix[1][0] * standardCart[X] + convMatrix[1][1] * standardCart[Y] + convMatrix[1][2] * standardCart[Z];
     // std::cout statement for debugging
     // std::cout << "After conversion: " << result.x << ", " << result.y << ", "
-    //   	      << conv::convMatrix[2][0] * standardCart[X] + conv::convMatrix[2][1] * standardCart[Y] + conv::convMatrix[2][2] * standardCart[Z] << '\n';
+    //   	      << convMatrix[2][0] * standardCart[X] + convMatrix[2][1] * standardCart[Y] + convMatrix[2][2] * standardCart[Z] << '\n';
     return result;
 }
 
-void CoordtoGPS(const Coord& c, float_type &longitude, float_type &latitude) // Converts a coordinate in our coordinate system to GPS longitude and latitude in radians
+void LocalFrame::toGPS(const Coord &c, float_type &longitude, float_type &latitude) const // Converts a coordinate in our coordinate system to GPS longitude and latitude in radians
 {
     float_type standardCoord[3] = {};
-    standardCoord[X] = c.x * conv::ourX[X] + c.y * conv::ourY[X]; // Get the X value in standard basis
-    standardCoord[Y] = c.x * conv::ourX[Y] + c.y * conv::ourY[Y]; // Get the Y value in standard basis
-    standardCoord[Z] = c.x * conv::ourX[Z] + c.y * conv::ourY[Z]; // Get the Z value in standard basis
+    standardCoord[X] = c.x * ourX[X] + c.y * ourY[X]; // Get the X value in standard basis
+    standardCoord[Y] = c.x * ourX[Y] + c.y * ourY[Y]; // Get the Y value in standard basis
+    standardCoord[Z] = c.x * ourX[Z] + c.y * ourY[Z]; // Get the Z value in standard basis
     // Shift the origin back to the center of the Earth
-    standardCoord[X] += conv::refCart[X];
-    standardCoord[Y] += conv::refCart[Y];
-    standardCoord[Z] += conv::refCart[Z];
+    standardCoord[X] += refCart[X];
+    standardCoord[Y] += refCart[Y];
+    standardCoord[Z] += refCart[Z];
     longitude = atan2(standardCoord[Y], standardCoord[X]);
     latitude = asin(standardCoord[Z] / EARTH_RADIUS);
 }
 
-void computeBasis() // Compute our basis vectors based on the given reference point
+void LocalFrame::toCoordBatch(const float_type *longitude, const float_type *latitude, size_t n, Coord *out) const // Converts n GPS coordinates at once
 {
-    // Compute our Z basis vector
-    conv::ourZ = conv::refCart;
-    float_type length = sqrt(conv::ourZ[X] * conv::ourZ[X] + conv::ourZ[Y] * conv::ourZ[Y] + conv::ourZ[Z] * conv::ourZ[Z]);
-    // Compute our X basis vector using equation of the plane at reference point
-    conv::ourX[X] = (1.0);
-    conv::ourX[Y] = (0);
-    conv::ourX[Z] = ((conv::ourZ[X] * conv::refCart[X] - conv::ourZ[X] * conv::ourX[X] + conv::ourZ[Y] * conv::refCart[Y] - conv::ourZ[Y] * conv::ourX[Y] + conv::ourZ[Z] * conv::refCart[Z]) / conv::ourZ[Z]);
-    // Make our X the positional vector anchored at conv::refCart and pointing towards the point we just calculated on the plane
-    conv::ourX[X] -= conv::refCart[X];
-    conv::ourX[Y] -= conv::refCart[Y];
-    conv::ourX[Z] -= conv::refCart[Z];
-    // Cross our X and our Z to get our Y
-    conv::ourY[X] = (conv::ourZ[Y] * conv::ourX[Z] - conv::ourZ[Z] * conv::ourX[Y]);
-    conv::ourY[Y] = (-(conv::ourZ[X] * conv::ourX[Z] - conv::ourZ[Z] * conv::ourX[X]));
-    conv::ourY[Z] = (conv::ourZ[X] * conv::ourX[Y] - conv::ourZ[Y] * conv::ourX[X]);
-    // Scale basis vectors to unit length
-    for (unsigned int i = 0; i < conv::ourZ.size(); ++i)
-	conv::ourZ[i] /= length;
-    length = sqrt(conv::ourX[X] * conv::ourX[X] + conv::ourX[Y] * conv::ourX[Y] + conv::ourX[Z] * conv::ourX[Z]);
-    for (unsigned int i = 0; i < conv::ourX.size(); ++i)
-	conv::ourX[i] /= length;
-    length = sqrt(conv::ourY[X] * conv::ourY[X] + conv::ourY[Y] * conv::ourY[Y] + conv::ourY[Z] * conv::ourY[Z]);
-    for (unsigned int i = 0; i < conv::ourY.size(); ++i)
-	conv::ourY[i] /= length;
-    // Compute the conversion matrix by inverting the standard matrix
-    float_type standardMatrix[3][3] =
-	{
-	    {conv::ourX[X], conv::ourY[X], conv::ourZ[X]},
-	    {conv::ourX[Y], conv::ourY[Y], conv::ourZ[Y]},
-	    {conv::ourX[Z], conv::ourY[Z], conv::ourZ[Z]}
-	};
-    float_type determinate = (standardMatrix[0][0] * (standardMatrix[1][1] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][1])) -
-	(standardMatrix[0][1] * (standardMatrix[1][0] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][0])) +
-	(standardMatrix[0][2] * (standardMatrix[1][0] * standardMatrix[2][1] - standardMatrix[1][1] * standardMatrix[2][0]));
-    for (unsigned int i = 0; i < 3; ++i) // Transpose the standard matrix
-	for (unsigned int j = i; j < 3; ++j)
-	    std::swap(standardMatrix[i][j], standardMatrix[j][i]);
-    conv::convMatrix[0][0] = standardMatrix[1][1] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][1];
-    conv::convMatrix[0][1] = standardMatrix[1][0] * standardMatrix[2][2] - standardMatrix[1][2] * standardMatrix[2][0];
-    conv::convMatrix[0][2] = standardMatrix[1][0] * standardMatrix[2][1] - standardMatrix[1][1] * standardMatrix[2][0];
-    conv::convMatrix[1][0] = standardMatrix[0][1] * standardMatrix[2][2] - standardMatrix[0][2] * standardMatrix[2][1];
-    conv::convMatrix[1][1] = standardMatrix[0][0] * standardMatrix[2][2] - standardMatrix[0][2] * standardMatrix[2][0];
-    conv::convMatrix[1][2] = standardMatrix[0][0] * standardMatrix[2][1] - standardMatrix[0][1] * standardMatrix[2][0];
-    conv::convMatrix[2][0] = standardMatrix[0][1] * standardMatrix[1][2] - standardMatrix[0][2] * standardMatrix[1][1];
-    conv::convMatrix[2][1] = standardMatrix[0][0] * standardMatrix[1][2] - standardMatrix[0][2] * standardMatrix[1][0];
-    conv::convMatrix[2][2] = standardMatrix[0][0] * standardMatrix[1][1] - standardMatrix[0][1] * standardMatrix[1][0];
-    for (unsigned int i = 0; i < 3; ++i)
-	for (unsigned int j = 0; j < 3; ++j)
-	    conv::convMatrix[i][j] /= determinate;
-    conv::convMatrix[0][1] *= -1;
-    conv::convMatrix[1][0] *= -1;
-    conv::convMatrix[1][2] *= -1;
-    conv::convMatrix[2][1] *= -1;
+    size_t i = 0;
+#ifdef __AVX2__
+    if (std::is_same<float_type, double>::value && sizeof(Coord) == 2 * sizeof(double))
+    {
+        // Trig stays scalar since there is no vector sin/cos to call. The shift and matrix multiply then run
+        // on four points at a time and the results are interleaved straight into the Coord array
+        const __m256d m00 = _mm256_set1_pd(convMatrix[0][0]), m01 = _mm256_set1_pd(convMatrix[0][1]), m02 = _mm256_set1_pd(convMatrix[0][2]);
+        const __m256d m10 = _mm256_set1_pd(convMatrix[1][0]), m11 = _mm256_set1_pd(convMatrix[1][1]), m12 = _mm256_set1_pd(convMatrix[1][2]);
+        const __m256d refX = _mm256_set1_pd(refCart[X]), refY = _mm256_set1_pd(refCart[Y]), refZ = _mm256_set1_pd(refCart[Z]);
+        alignas(32) double cartX[4], cartY[4], cartZ[4];
+        for (; i + 4 <= n; i += 4)
+        {
+            for (unsigned int k = 0; k < 4; ++k)
+            {
+                double cart[3];
+                GPStoCartesian(longitude[i + k], latitude[i + k], cart);
+                cartX[k] = cart[X];
+                cartY[k] = cart[Y];
+                cartZ[k] = cart[Z];
+            }
+            __m256d px = _mm256_sub_pd(_mm256_load_pd(cartX), refX);
+            __m256d py = _mm256_sub_pd(_mm256_load_pd(cartY), refY);
+            __m256d pz = _mm256_sub_pd(_mm256_load_pd(cartZ), refZ);
+            __m256d x = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m00, px), _mm256_mul_pd(m01, py)), _mm256_mul_pd(m02, pz));
+            __m256d y = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m10, px), _mm256_mul_pd(m11, py)), _mm256_mul_pd(m12, pz));
+            __m256d lo = _mm256_unpacklo_pd(x, y); // x0 y0 x2 y2
+            __m256d hi = _mm256_unpackhi_pd(x, y); // x1 y1 x3 y3
+            _mm256_storeu_pd((double *)(out + i), _mm256_permute2f128_pd(lo, hi, 0x20));
+            _mm256_storeu_pd((double *)(out + i + 2), _mm256_permute2f128_pd(lo, hi, 0x31));
+        }
+    }
+#endif
+    for (; i < n; ++i) // Remaining points
+        out[i] = toCoord(longitude[i], latitude[i]);
 }
 
+void LocalFrame::toGPSBatch(const Coord *c, size_t n, float_type *longitude, float_type *latitude) const // Converts n coordinates back to GPS at once
+{
+    size_t i = 0;
+#ifdef __AVX2__
+    if (std::is_same<float_type, double>::value && sizeof(Coord) == 2 * sizeof(double))
+    {
+        const __m256d xX = _mm256_set1_pd(ourX[X]), xY = _mm256_set1_pd(ourX[Y]), xZ = _mm256_set1_pd(ourX[Z]);
+        const __m256d yX = _mm256_set1_pd(ourY[X]), yY = _mm256_set1_pd(ourY[Y]), yZ = _mm256_set1_pd(ourY[Z]);
+        const __m256d refX = _mm256_set1_pd(refCart[X]), refY = _mm256_set1_pd(refCart[Y]), refZ = _mm256_set1_pd(refCart[Z]);
+        alignas(32) double cartX[4], cartY[4], cartZ[4];
+        for (; i + 4 <= n; i += 4)
+        {
+            // Split the interleaved Coords into a vector of x values and a vector of y values
+            __m256d a = _mm256_loadu_pd((const double *)(c + i)); // x0 y0 x1 y1
+            __m256d b = _mm256_loadu_pd((const double *)(c + i + 2)); // x2 y2 x3 y3
+            __m256d lo = _mm256_permute2f128_pd(a, b, 0x20); // x0 y0 x2 y2
+            __m256d hi = _mm256_permute2f128_pd(a, b, 0x31); // x1 y1 x3 y3
+            __m256d x = _mm256_unpacklo_pd(lo, hi); // x0 x1 x2 x3
+            __m256d y = _mm256_unpackhi_pd(lo, hi); // y0 y1 y2 y3
+            _mm256_store_pd(cartX, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, xX), _mm256_mul_pd(y, yX)), refX));
+            _mm256_store_pd(cartY, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, xY), _mm256_mul_pd(y, yY)), refY));
+            _mm256_store_pd(cartZ, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, xZ), _mm256_mul_pd(y, yZ)), refZ));
+            for (unsigned int k = 0; k < 4; ++k)
+            {
+                longitude[i + k] = atan2(cartY[k], cartX[k]);
+                latitude[i + k] = asin(cartZ[k] / EARTH_RADIUS);
+            }
+        }
+    }
+#endif
+    for (; i < n; ++i) // Remaining coordinates
+        toGPS(c[i], longitude[i], latitude[i]);
+}
 
 inline float_type toRadians(float_type degrees) // Degrees to radians
 { return degrees * (PI / 180.0); }
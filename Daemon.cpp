@@ -0,0 +1,531 @@
+/**
+ * @file Daemon.cpp
+ * @brief Long running planner that answers requests over a Unix domain socket.
+ * A request is a block of key=value lines ended by an empty line. Points are given as a flat comma
+ * separated list of latitudes and longitudes in degrees.
+ * <ul>
+ *   <li>search=lat,lon,lat,lon,... the search grid polygon. Required</li>
+ *   <li>bounds=lat,lon,lat,lon,... the boundary polygon. Transits are not routed if it is left out</li>
+ *   <li>start=lat,lon the last mission point the search path is entered from</li>
+ *   <li>mode=naive or mode=decomp</li>
+ *   <li>completed=n resumes the search path after its first n sweep legs, from start as the drone's current position</li>
+ *   <li>altitude, radius, offset and correction override the daemon's parameters for this request</li>
+ * </ul>
+ * The reply is a line "ok n" followed by n lines of "lat,lon,altitude" search path waypoints, or a single
+ * line "error message". A connection can send any number of requests. Requests longer than DAEMON_MAX_REQUEST
+ * bytes are answered with an error and the connection is closed, as are connections idle for DAEMON_IDLE_TIMEOUT
+ * seconds so one stalled client cannot hold up the others. Boundary indexes and planned search
+ * paths are kept between requests so replanning the same area from a new start point only routes the transits,
+ * and when a search area is edited only the pieces containing moved vertices are decomposed and swept again.
+ * The first search point anchors the local frame, so moving it replans the whole area.
+ * @see PlanDaemon
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <iostream>
+#include <charconv>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+#include "Mission.cpp"
+
+/**
+ * @brief A small least recently used cache keyed by the exact inputs a value was built from.
+ * Lookups are a linear scan since the cache only holds a handful of entries.
+ * @tparam V the cached type
+ */
+template <typename V>
+struct LruCache
+{
+    /**
+     * @brief A cached value and the inputs it was built from.
+     */
+    struct Entry
+    {
+        std::vector<float_type> key;
+        std::unique_ptr<V> value;
+    };
+
+    /**
+     * @brief The entries from most to least recently used.
+     */
+    std::list<Entry> entries;
+    /**
+     * @brief The maximum number of entries.
+     */
+    size_t capacity;
+
+    /**
+     * @brief Construct an empty cache.
+     * @param n the maximum number of entries
+     */
+    LruCache(size_t n = DAEMON_CACHE_SIZE): capacity(n)
+    {}
+    /**
+     * @brief Look up a value and mark it as most recently used.
+     * @param key the inputs the value was built from
+     * @return pointer to the value or NULL if it is not cached
+     */
+    V* find(const std::vector<float_type> &key)
+    {
+        for (typename std::list<Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it->key == key)
+            {
+                entries.splice(entries.begin(), entries, it);
+                return entries.front().value.get();
+            }
+        }
+        return NULL;
+    }
+    /**
+     * @brief Add a value, evicting the least recently used entries if the cache is full.
+     * @param key the inputs the value was built from
+     * @param value the value
+     * @return pointer to the cached value
+     */
+    V* insert(const std::vector<float_type> &key, std::unique_ptr<V> value)
+    {
+        entries.push_front(Entry());
+        entries.front().key = key;
+        entries.front().value = std::move(value);
+        while (entries.size() > capacity)
+            entries.pop_back();
+        return entries.front().value.get();
+    }
+};
+
+/**
+ * @brief A parsed planning request.
+ */
+struct PlanRequest
+{
+    /**
+     * @brief The daemon's parameters with this request's overrides.
+     */
+    PlannerConfig config;
+    /**
+     * @brief Whether to use naive path generation with no decomposition.
+     */
+    bool naive;
+    /**
+     * @brief The search grid polygon. Altitudes are unused.
+     */
+    std::vector<PointRecord> search;
+    /**
+     * @brief The boundary polygon. Altitudes are unused.
+     */
+    std::vector<PointRecord> bounds;
+    /**
+     * @brief The last mission point. Only used if hasStart is set.
+     */
+    PointRecord start;
+    /**
+     * @brief Whether a start point was given.
+     */
+    bool hasStart;
+    /**
+     * @brief Number of sweep legs already flown. Only used if resume is set.
+     */
+    size_t completed;
+    /**
+     * @brief Whether to plan the rest of an interrupted search path from the start point.
+     */
+    bool resume;
+
+    PlanRequest(): naive(false), hasStart(false), completed(0), resume(false)
+    {}
+};
+
+/**
+ * @brief Parse a comma separated list of latitudes and longitudes.
+ * @param value the list
+ * @param points stores one record per latitude and longitude pair
+ * @return true if the list was a whole number of pairs, else false
+ */
+bool parsePointList(const std::string &value, std::vector<PointRecord> &points)
+{
+    const char *curr = value.data();
+    const char *end = curr + value.size();
+    points.clear();
+    while (curr < end)
+    {
+        PointRecord point;
+        if (!parseField(curr, end, point.latitude) || curr == end || !parseField(curr, end, point.longitude))
+            return false;
+        point.ordinal = points.size() + 1;
+        points.push_back(point);
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the lines of a request.
+ * @param lines the key=value lines of the request
+ * @param request stores the request. Its config and naive flag must already hold the defaults
+ * @param error stores why the request is invalid
+ * @return true if every line was valid and a search area was given, else false
+ */
+bool parseRequest(const std::vector<std::string> &lines, PlanRequest &request, std::string &error)
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        std::string::size_type eq = lines[i].find('=');
+        std::string key = lines[i].substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : lines[i].substr(eq + 1);
+        bool ok;
+        if (eq == std::string::npos)
+            ok = false;
+        else if (key == "search")
+            ok = parsePointList(value, request.search);
+        else if (key == "bounds")
+            ok = parsePointList(value, request.bounds);
+        else if (key == "start")
+        {
+            std::vector<PointRecord> points;
+            ok = parsePointList(value, points) && points.size() == 1;
+            if (ok)
+                request.start = points[0];
+            request.hasStart = ok;
+        }
+        else if (key == "mode")
+        {
+            ok = value == "naive" || value == "decomp";
+            request.naive = value == "naive";
+        }
+        else if (key == "completed")
+        {
+            ok = !value.empty() && value.size() < 19 && value.find_first_not_of("0123456789") == std::string::npos;
+            if (ok)
+                request.completed = std::stoull(value);
+            request.resume = ok;
+        }
+        else if (key == "altitude" || key == "radius" || key == "offset" || key == "correction")
+            ok = request.config.set(key, value);
+        else
+            ok = false;
+        if (!ok)
+        {
+            error = "Invalid request line: " + lines[i];
+            return false;
+        }
+    }
+    if (request.search.size() < 3)
+    {
+        error = "Request has no search area";
+        return false;
+    }
+    if (request.resume && !request.hasStart)
+    {
+        error = "Request has completed legs but no current position";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Plans search paths for requests read from a Unix domain socket.
+ * Connections are served one at a time and the planner's own parallel loops run on the shared thread pool.
+ * A connection is closed once it stays idle for DAEMON_IDLE_TIMEOUT seconds.
+ * @see Daemon.cpp
+ */
+struct PlanDaemon
+{
+    /**
+     * @brief Defaults for parameters a request leaves out.
+     */
+    PlannerConfig config;
+    /**
+     * @brief Whether requests that leave out the mode use naive path generation.
+     */
+    bool naive;
+    /**
+     * @brief Boundary indexes keyed by the frame anchor, radius and boundary points they were built from.
+     * @see BoundaryIndex
+     */
+    LruCache<BoundaryIndex> boundaries;
+    /**
+     * @brief Planned search paths keyed by the mode, offset, radius, correction and search points they were planned from.
+     * The paths have not been read from so each request reads its own copy.
+     * @see PathStream
+     */
+    LruCache<PathStream> paths;
+    /**
+     * @brief What the latest plan decomposed and swept, so edits to a search area only replan the pieces they touch.
+     * @see PlanMemo
+     */
+    PlanMemo memo;
+    /**
+     * @brief Number of requests answered.
+     */
+    unsigned int requests;
+
+    /**
+     * @brief Construct the daemon.
+     * @param c defaults for parameters a request leaves out
+     * @param naiveDefault whether requests that leave out the mode use naive path generation
+     */
+    PlanDaemon(const PlannerConfig &c, bool naiveDefault): config(c), naive(naiveDefault), requests(0)
+    {}
+    /**
+     * @brief Plan a request.
+     * @param request the request
+     * @param response stores the reply
+     * @return true if the search path was planned, else false
+     */
+    bool plan(const PlanRequest &request, std::string &response)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const PlannerConfig &c = request.config;
+        // The first search point is the origin as in planMission() so the same mission gives the same path
+        const LocalFrame frame(toRadians(request.search[0].longitude), toRadians(request.search[0].latitude));
+        std::vector<float_type> longitudes, latitudes; // Scratch arrays for batch conversion
+
+        // Find or build the boundary index
+        std::vector<float_type> key;
+        BoundaryIndex *index = NULL;
+        bool boundaryHit = false;
+        if (!request.bounds.empty())
+        {
+            key.push_back(request.search[0].latitude);
+            key.push_back(request.search[0].longitude);
+            key.push_back(c.radius);
+            for (size_t k = 0; k < request.bounds.size(); ++k)
+            {
+                key.push_back(request.bounds[k].latitude);
+                key.push_back(request.bounds[k].longitude);
+            }
+            index = boundaries.find(key);
+            boundaryHit = index != NULL;
+            if (index == NULL)
+            {
+                Polygon boundary;
+                toCoords(frame, request.bounds, boundary.v, longitudes, latitudes);
+                if (clockwise(boundary.v))
+                    std::reverse(boundary.v.begin(), boundary.v.end());
+                index = boundaries.insert(key, std::unique_ptr<BoundaryIndex>(new BoundaryIndex(boundary, c.radius)));
+            }
+        }
+
+        // Find or plan the search path
+        key.clear();
+        key.push_back(request.naive);
+        key.push_back(c.offset);
+        key.push_back(c.radius);
+        key.push_back(c.correction);
+        for (size_t k = 0; k < request.search.size(); ++k)
+        {
+            key.push_back(request.search[k].latitude);
+            key.push_back(request.search[k].longitude);
+        }
+        PathStream *planned = paths.find(key);
+        bool pathHit = planned != NULL;
+        if (planned == NULL)
+        {
+            Polygon searchArea;
+            toCoords(frame, request.search, searchArea.v, longitudes, latitudes);
+            searchArea.v[0] = Coord(0, 0); // Treat the first coordinate as the origin
+            if (clockwise(searchArea.v)) // Ensure points are in counter-clockwise order
+                std::reverse(searchArea.v.begin(), searchArea.v.end());
+            memo.reused = 0;
+            memo.reusedOrder = false;
+            PathStream stream = cachedPathStream(searchArea, request.naive, NULL, c, &memo);
+            planned = paths.insert(key, std::unique_ptr<PathStream>(new PathStream(std::move(stream))));
+        }
+        PathStream path;
+        if (request.resume) // Reorder what is left of the cached plan from the current position
+            path = resumePathStream(*planned, request.completed, frame.toCoord(toRadians(request.start.longitude), toRadians(request.start.latitude)));
+        else
+        {
+            path = *planned;
+            if (request.hasStart)
+                path.setStart(frame.toCoord(toRadians(request.start.longitude), toRadians(request.start.latitude)));
+        }
+        path.boundary = index; // Transits are left unrouted without a boundary
+
+        // Read the waypoints out
+        std::vector<Coord> waypoints;
+        Coord waypoint;
+        while (path.next(waypoint))
+            waypoints.push_back(waypoint);
+        if (path.failed)
+        {
+            response = "No route between search waypoints stays inside the boundary";
+            return false;
+        }
+        longitudes.resize(waypoints.size());
+        latitudes.resize(waypoints.size());
+        if (!waypoints.empty())
+            frame.toGPSBatch(&waypoints[0], waypoints.size(), &longitudes[0], &latitudes[0]);
+        char line[WAYPOINT_MAX_CHARS];
+        response = "ok " + std::to_string(waypoints.size()) + '\n';
+        response.reserve(response.size() + waypoints.size() * 40);
+        for (size_t k = 0; k < waypoints.size(); ++k)
+        {
+            char *curr = line, *end = line + sizeof(line);
+            curr = std::to_chars(curr, end, toDegrees(latitudes[k]), std::chars_format::fixed, WAYPOINT_PRECISION).ptr;
+            *curr++ = ',';
+            curr = std::to_chars(curr, end, toDegrees(longitudes[k]), std::chars_format::fixed, WAYPOINT_PRECISION).ptr;
+            *curr++ = ',';
+            curr = std::to_chars(curr, end, c.altitude).ptr;
+            *curr++ = '\n';
+            response.append(line, curr - line);
+        }
+        ++requests;
+        std::cout << "Request " << requests << ": " << waypoints.size() << " waypoints in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms"
+                  << (boundaryHit ? ", cached boundary" : "") << (pathHit ? ", cached path" : "")
+                  << (request.resume ? ", resumed after " + std::to_string(request.completed) + " legs" : "");
+        if (!pathHit && memo.reused > 0)
+            std::cout << ", reused " << memo.reused << " pieces" << (memo.reusedOrder ? " and the order" : "");
+        std::cout << std::endl;
+        return true;
+    }
+#ifndef _WIN32
+    /**
+     * @brief Write a whole reply to a connection.
+     * @param fd the connection
+     * @param data the reply
+     * @return true if every byte was written, else false
+     */
+    static bool sendAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = write(fd, data.data() + sent, data.size() - sent);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            sent += n;
+        }
+        return true;
+    }
+    /**
+     * @brief Answer requests from a connection until it is closed, times out or sends a request that is too large.
+     * @param fd the connection. Reads and writes on it must time out after DAEMON_IDLE_TIMEOUT seconds
+     */
+    void handle(int fd)
+    {
+        std::string buffer; // Bytes read but not yet split into lines
+        std::vector<std::string> lines; // Lines of the request being read
+        size_t size = 0; // Bytes in lines
+        char chunk[4096];
+        while (true)
+        {
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) // Closed, failed or idle for too long
+                return;
+            buffer.append(chunk, n);
+            std::string::size_type begin = 0, newline;
+            while ((newline = buffer.find('\n', begin)) != std::string::npos)
+            {
+                std::string line = buffer.substr(begin, newline - begin);
+                begin = newline + 1;
+                if (!line.empty() && line[line.size() - 1] == '\r')
+                    line.erase(line.size() - 1);
+                if (!line.empty())
+                {
+                    size += line.size() + 1;
+                    if (size > DAEMON_MAX_REQUEST)
+                        break;
+                    lines.push_back(line);
+                    continue;
+                }
+                if (lines.empty()) // Blank lines between requests
+                    continue;
+                PlanRequest request;
+                request.config = config;
+                request.naive = naive;
+                std::string response;
+                if (!parseRequest(lines, request, response) || !plan(request, response))
+                    response = "error " + response + '\n';
+                lines.clear();
+                size = 0;
+                if (!sendAll(fd, response))
+                    return;
+            }
+            buffer.erase(0, begin);
+            if (size + buffer.size() > DAEMON_MAX_REQUEST) // The rest of the request cannot be told apart from the next, so hang up
+            {
+                sendAll(fd, "error Request is too large\n");
+                return;
+            }
+        }
+    }
+#endif
+    /**
+     * @brief Listen on a socket and answer requests until the process is stopped.
+     * An existing file at the socket path is replaced.
+     * @param path path of the socket
+     * @return false if the socket could not be set up
+     */
+    bool serve(const std::string &path)
+    {
+#ifdef _WIN32
+        std::cout << "Error: The planning daemon needs Unix domain sockets, which this build does not support\n";
+        return false;
+#else
+        signal(SIGPIPE, SIG_IGN); // Clients that hang up are seen as failed writes instead
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            std::cout << "Error: Socket path is too long: " << path << '\n';
+            return false;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size());
+        int server = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server < 0)
+        {
+            std::cout << "Error: Could not create socket: " << strerror(errno) << '\n';
+            return false;
+        }
+        unlink(path.c_str());
+        if (bind(server, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(server, 16) < 0)
+        {
+            std::cout << "Error: Could not listen on " << path << ": " << strerror(errno) << '\n';
+            close(server);
+            return false;
+        }
+        std::cout << "Listening on " << path << std::endl;
+        while (true)
+        {
+            int client = accept(server, NULL, NULL);
+            if (client < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cout << "Error: Could not accept connection: " << strerror(errno) << '\n';
+                close(server);
+                return false;
+            }
+            timeval timeout;
+            timeout.tv_sec = DAEMON_IDLE_TIMEOUT;
+            timeout.tv_usec = 0;
+            if (setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0 ||
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0)
+                std::cout << "Error: Could not set connection timeout: " << strerror(errno) << '\n';
+            else
+                handle(client);
+            close(client);
+        }
+#endif
+    }
+};
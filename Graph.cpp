@@ -1,77 +1,275 @@
 /**
  * @file Graph.cpp
  * @brief Simple weighted directed graph implementation.
+ * How the edges are stored is chosen with a storage policy. DenseStorage keeps a weight for every
+ * ordered pair of vertices and suits complete graphs like the subregion graph. SparseStorage keeps
+ * only the edges in compressed sparse row form so neighbors are visited in O(degree).
  * @author Harvey Lin
  */
+#pragma once
 #include <cstdlib>
+#include <cassert>
+#include <vector>
+#include <algorithm>
 
 /**
- * @brief A simple weighted directed graph.
+ * @brief Edge storage as a single n * n array of weights and edge flags.
+ * Every ordered pair has a weight whether or not it is an edge.
  */
-template <typename E, typename W>
-struct Graph 
+template <typename W>
+struct DenseStorage
 {
     /**
-     * @brief The number of vertices stored in the graph.
+     * @brief The weight and edge flag of one ordered pair of vertices.
      */
-    const unsigned int numVerts;
+    struct Cell
+    {
+        W weight;
+        bool edge;
+
+        Cell(): weight(), edge(false)
+        {}
+    };
+
     /**
-     * @brief The list of vertices.
+     * @brief The number of vertices.
+     */
+    unsigned int n;
+    /**
+     * @brief The cells of every ordered pair stored row major.
+     */
+    std::vector<Cell> cells;
+
+    /**
+     * @brief Construct the storage with no edges and zero weights.
+     * @param numVerts number of vertices
      */
-    E *v;
+    DenseStorage(unsigned int numVerts = 0): n(numVerts), cells((size_t)numVerts * numVerts)
+    {}
+    bool hasEdge(unsigned int v1, unsigned int v2) const
+    { return cells[(size_t)v1 * n + v2].edge; }
+    W weight(unsigned int v1, unsigned int v2) const
+    { return cells[(size_t)v1 * n + v2].weight; }
+    void setWeight(unsigned int v1, unsigned int v2, W w)
+    { cells[(size_t)v1 * n + v2].weight = w; }
+    void setEdge(unsigned int v1, unsigned int v2)
+    { cells[(size_t)v1 * n + v2].edge = true; }
+    void removeEdge(unsigned int v1, unsigned int v2)
+    { cells[(size_t)v1 * n + v2].edge = false; }
     /**
-     * @brief Adjacency matrix representing edges in the graph.
+     * @brief Call f(target, weight) for each edge leaving a vertex in order of target.
+     * @param vert index of the vertex
+     * @param f the function to call
      */
-    bool **e;
+    template <typename F>
+    void forEachNext(unsigned int vert, F f) const
+    {
+        const Cell *row = &cells[(size_t)vert * n];
+        for (unsigned int i = 0; i < n; ++i)
+            if (row[i].edge)
+                f(i, row[i].weight);
+    }
     /**
-     * @brief Weight matrix for each directional edge.
+     * @brief Find a vertex with an edge into a vertex.
+     * @param vert index of the vertex
+     * @return index of the lowest such vertex or -1 if there is none
      */
-    W **w;
+    int firstPrev(unsigned int vert) const
+    {
+        for (unsigned int i = 0; i < n; ++i)
+            if (hasEdge(i, vert))
+                return i;
+        return -1;
+    }
+};
 
+/**
+ * @brief Edge storage in compressed sparse row form.
+ * The targets and weights of each vertex's edges are stored contiguously and sorted by target.
+ * Pairs that are not edges have no weight. Adding an edge is O(n + number of edges) so a storage with
+ * many edges should be built at once from an edge list and then read.
+ */
+template <typename W>
+struct SparseStorage
+{
     /**
-     * @brief Construct the graph with a specified number of vertices.
-     * @param n number of vertices in the graph
+     * @brief The number of vertices.
      */
-    Graph(const unsigned int n): numVerts(n)
+    unsigned int n;
+    /**
+     * @brief The edges of vertex i are at [offsets[i], offsets[i + 1]) in targets and weights.
+     */
+    std::vector<unsigned int> offsets;
+    /**
+     * @brief The target vertex of each edge.
+     */
+    std::vector<unsigned int> targets;
+    /**
+     * @brief The weight of each edge.
+     */
+    std::vector<W> weights;
+
+    /**
+     * @brief Construct the storage with no edges.
+     * @param numVerts number of vertices
+     */
+    SparseStorage(unsigned int numVerts = 0): n(numVerts), offsets(numVerts + 1, 0)
+    {}
+    /**
+     * @brief Construct the storage from a list of edges in O(n + number of edges).
+     * The edges are counted per source, the counts are summed into offsets and then each edge is placed.
+     * @param numVerts number of vertices
+     * @param sources the source vertex of each edge
+     * @param edgeTargets the target vertex of each edge
+     * @param edgeWeights the weight of each edge
+     */
+    SparseStorage(unsigned int numVerts, const std::vector<unsigned int> &sources, const std::vector<unsigned int> &edgeTargets,
+                  const std::vector<W> &edgeWeights): n(numVerts), offsets(numVerts + 1, 0), targets(sources.size()), weights(sources.size())
     {
-        v = new E[n];
-        e = new bool*[n];
-	w = new W*[n];
-        for (int i = 0; i < n; ++i)
-	{
-	    e[i] = new bool[n]();
-	    w[i] = new W[n]();
-	}
+        assert(edgeTargets.size() == sources.size() && edgeWeights.size() == sources.size());
+        for (size_t k = 0; k < sources.size(); ++k)
+            ++offsets[sources[k] + 1];
+        for (unsigned int i = 0; i < n; ++i)
+            offsets[i + 1] += offsets[i];
+        std::vector<unsigned int> next(offsets.begin(), offsets.end() - 1); // Where the next edge of each vertex goes
+        for (size_t k = 0; k < sources.size(); ++k)
+        {
+            unsigned int pos = next[sources[k]]++;
+            targets[pos] = edgeTargets[k];
+            weights[pos] = edgeWeights[k];
+        }
+        for (unsigned int i = 0; i < n; ++i) // Keep each row sorted by target for find()
+        {
+            bool sorted = true;
+            for (unsigned int k = offsets[i] + 1; k < offsets[i + 1] && sorted; ++k)
+                sorted = targets[k - 1] < targets[k];
+            if (sorted)
+                continue;
+            std::vector<std::pair<unsigned int, W> > row;
+            for (unsigned int k = offsets[i]; k < offsets[i + 1]; ++k)
+                row.push_back(std::make_pair(targets[k], weights[k]));
+            std::sort(row.begin(), row.end(), [](const std::pair<unsigned int, W> &a, const std::pair<unsigned int, W> &b) { return a.first < b.first; });
+            for (unsigned int k = offsets[i]; k < offsets[i + 1]; ++k)
+            {
+                targets[k] = row[k - offsets[i]].first;
+                weights[k] = row[k - offsets[i]].second;
+            }
+        }
     }
     /**
-     * @brief Construct the graph with an existing list of vertices.
-     * @param n number of vertices in the graph
-     * @param verts list of vertices
+     * @brief Find the position of an edge.
+     * @return index of the edge in targets or -1 if there is no such edge
      */
-    Graph(const unsigned int n, E *verts): numVerts(n)
+    int find(unsigned int v1, unsigned int v2) const
     {
-	v = verts;
-        e = new bool*[n];
-	w = new W*[n];
-        for (int i = 0; i < n; ++i)
-	{
-	    e[i] = new bool[n]();
-	    w[i] = new W[n]();
-	}
+        std::vector<unsigned int>::const_iterator begin = targets.begin() + offsets[v1], end = targets.begin() + offsets[v1 + 1];
+        std::vector<unsigned int>::const_iterator it = std::lower_bound(begin, end, v2);
+        return (it != end && *it == v2) ? (int)(it - targets.begin()) : -1;
     }
+    bool hasEdge(unsigned int v1, unsigned int v2) const
+    { return find(v1, v2) != -1; }
     /**
-     * @brief Destructor
+     * @brief Get the weight of an edge. Pairs that are not edges have a default constructed weight.
      */
-    ~Graph()
+    W weight(unsigned int v1, unsigned int v2) const
     {
-        delete[] v;
-        for (int i = 0; i < numVerts; ++i)
-	{
-	    delete[] e[i];
-	    delete[] w[i];
-	}
-        delete[] e;
-	delete[] w;
+        int k = find(v1, v2);
+        return k == -1 ? W() : weights[k];
+    }
+    /**
+     * @brief Set the weight of an edge. The edge must already exist.
+     */
+    void setWeight(unsigned int v1, unsigned int v2, W w)
+    {
+        int k = find(v1, v2);
+        assert(k != -1);
+        weights[k] = w;
+    }
+    void setEdge(unsigned int v1, unsigned int v2)
+    {
+        if (hasEdge(v1, v2))
+            return;
+        std::vector<unsigned int>::iterator it = std::lower_bound(targets.begin() + offsets[v1], targets.begin() + offsets[v1 + 1], v2);
+        size_t k = it - targets.begin();
+        targets.insert(it, v2);
+        weights.insert(weights.begin() + k, W());
+        for (unsigned int i = v1 + 1; i <= n; ++i)
+            ++offsets[i];
+    }
+    void removeEdge(unsigned int v1, unsigned int v2)
+    {
+        int k = find(v1, v2);
+        if (k == -1)
+            return;
+        targets.erase(targets.begin() + k);
+        weights.erase(weights.begin() + k);
+        for (unsigned int i = v1 + 1; i <= n; ++i)
+            --offsets[i];
+    }
+    /**
+     * @brief Call f(target, weight) for each edge leaving a vertex in order of target.
+     * @param vert index of the vertex
+     * @param f the function to call
+     */
+    template <typename F>
+    void forEachNext(unsigned int vert, F f) const
+    {
+        for (unsigned int k = offsets[vert]; k < offsets[vert + 1]; ++k)
+            f(targets[k], weights[k]);
+    }
+    /**
+     * @brief Find a vertex with an edge into a vertex.
+     * @param vert index of the vertex
+     * @return index of the lowest such vertex or -1 if there is none
+     */
+    int firstPrev(unsigned int vert) const
+    {
+        for (unsigned int i = 0; i < n; ++i)
+            if (hasEdge(i, vert))
+                return i;
+        return -1;
+    }
+};
+
+/**
+ * @brief A simple weighted directed graph.
+ * @tparam E the vertex type
+ * @tparam W the weight type
+ * @tparam Storage the edge storage policy, DenseStorage or SparseStorage
+ */
+template <typename E, typename W, template <typename> class Storage = DenseStorage>
+struct Graph
+{
+    /**
+     * @brief The list of vertices.
+     */
+    std::vector<E> v;
+    /**
+     * @brief The edges and their weights.
+     * @see DenseStorage SparseStorage
+     */
+    Storage<W> edges;
+
+    /**
+     * @brief Construct the graph with a specified number of vertices.
+     * @param n number of vertices in the graph
+     */
+    Graph(const unsigned int n = 0): v(n), edges(n)
+    {}
+    /**
+     * @brief Construct the graph with an existing list of vertices.
+     * @param verts list of vertices
+     */
+    Graph(std::vector<E> verts): v(std::move(verts)), edges(v.size())
+    {}
+    /**
+     * @brief Construct the graph with an existing list of vertices and prebuilt edges.
+     * @param verts list of vertices
+     * @param storage the edges between the vertices
+     */
+    Graph(std::vector<E> verts, Storage<W> storage): v(std::move(verts)), edges(std::move(storage))
+    {
+        assert(edges.n == v.size());
     }
     /**
      * @brief Get an arbitrary previous vertex.
@@ -80,10 +278,8 @@ struct Graph
      */
     E* prev(int vert)
     {
-        for (int i = 0; i < numVerts; ++i)
-            if (e[i][vert])
-                return &v[i];
-        return NULL;
+        int i = edges.firstPrev(vert);
+        return i == -1 ? NULL : &v[i];
     }
     /**
      * @brief Get an arbitrary next vertex.
@@ -92,10 +288,39 @@ struct Graph
      */
     E* next(int vert)
     {
-        for (int i = 0; i < numVerts; ++i)
-            if (e[vert][i])
-                return &v[i];
-        return NULL;
+        int found = -1;
+        edges.forEachNext(vert, [&found](unsigned int i, W) { if (found == -1) found = i; });
+        return found == -1 ? NULL : &v[found];
+    }
+    /**
+     * @brief Check if the graph has an edge.
+     * @param v1 index of first vertex of edge
+     * @param v2 index of second vertex of edge
+     * @return true if the edge exists, else false
+     */
+    bool hasEdge(const unsigned int v1, const unsigned int v2) const
+    {
+        assert(v1 < size() && v2 < size());
+        return edges.hasEdge(v1, v2);
+    }
+    /**
+     * @brief Get the weight from one vertex to another.
+     * @param v1 index of first vertex
+     * @param v2 index of second vertex
+     * @return the weight
+     */
+    W weight(const unsigned int v1, const unsigned int v2) const
+    { return edges.weight(v1, v2); }
+    /**
+     * @brief Set the weight from one vertex to another.
+     * @param v1 index of first vertex
+     * @param v2 index of second vertex
+     * @param w the weight
+     */
+    void setWeight(const unsigned int v1, const unsigned int v2, W w)
+    {
+        assert(v1 < size() && v2 < size());
+        edges.setWeight(v1, v2, w);
     }
     /**
      * @brief Add an edge to the graph.
@@ -104,8 +329,8 @@ struct Graph
      */
     void setEdge(const unsigned int v1, const unsigned int v2)
     {
-        assert(v1 < numVerts && v2 < numVerts);
-        e[v1][v2] = true;
+        assert(v1 < size() && v2 < size());
+        edges.setEdge(v1, v2);
     }
     /**
      * @brief Remove an edge from the graph.
@@ -114,13 +339,22 @@ struct Graph
      */
     void removeEdge(const unsigned int v1, const unsigned int v2)
     {
-        assert (v1 < numVerts && v2 < numVerts);
-        e[v1][v2] = false;
+        assert (v1 < size() && v2 < size());
+        edges.removeEdge(v1, v2);
     }
+    /**
+     * @brief Call f(target, weight) for each edge leaving a vertex in order of target.
+     * Takes O(degree) with SparseStorage and O(n) with DenseStorage.
+     * @param vert index of the vertex
+     * @param f the function to call
+     */
+    template <typename F>
+    void forEachNext(const unsigned int vert, F f) const
+    { edges.forEachNext(vert, f); }
     /**
      * @brief Get the max number of vertices in the graph.
      * @return the number of vertices
      */
     unsigned int size() const
-    { return numVerts; }
+    { return v.size(); }
 };
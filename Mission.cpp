@@ -0,0 +1,202 @@
+/**
+ * @file Mission.cpp
+ * @brief Plans one mission from its point files to its output waypoint file.
+ * Everything a run needs, from the local frame to the conversion scratch arrays, is owned by the call,
+ * so separate missions can be planned at the same time on different threads.
+ * @see PlannerConfig
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include "Polygon.cpp"
+#include "Conversions.cpp"
+#include "Parser.cpp"
+#include "WaypointWriter.cpp"
+#include "PlanCache.cpp"
+
+/**
+ * @brief The outcome of planning one mission.
+ */
+struct MissionResult
+{
+    /**
+     * @brief Why the mission could not be planned, or empty if it was.
+     */
+    std::string error;
+    /**
+     * @brief Number of search path waypoints written after the mission points.
+     */
+    size_t waypoints;
+    /**
+     * @brief Length in meters of the search path, starting from the last mission point.
+     */
+    float_type pathLength;
+    /**
+     * @brief Time taken to plan and write the mission in milliseconds.
+     */
+    double millis;
+
+    MissionResult(): waypoints(0), pathLength(0), millis(0)
+    {}
+};
+
+/**
+ * @brief Convert point records to 2D coordinates in a local frame.
+ * @param frame the local frame
+ * @param points the records to convert
+ * @param coords stores one coordinate per record
+ * @param longitudes scratch array for the longitudes in radians
+ * @param latitudes scratch array for the latitudes in radians
+ * @see LocalFrame::toCoordBatch
+ */
+void toCoords(const LocalFrame &frame, const std::vector<PointRecord> &points, std::vector<Coord> &coords,
+              std::vector<float_type> &longitudes, std::vector<float_type> &latitudes)
+{
+    longitudes.resize(points.size());
+    latitudes.resize(points.size());
+    for (size_t k = 0; k < points.size(); ++k)
+    {
+        longitudes[k] = toRadians(points[k].longitude);
+        latitudes[k] = toRadians(points[k].latitude);
+    }
+    coords.resize(points.size());
+    if (!points.empty())
+        frame.toCoordBatch(&longitudes[0], &latitudes[0], points.size(), &coords[0]);
+}
+
+/**
+ * @brief Read a mission's point files, plan its search path and write the mission and search waypoints out.
+ * Does the work of planMission() apart from timing it.
+ * @param config the files and parameters of the mission
+ * @param naive true to use naive path generation with no decomposition
+ * @param result stores the outcome. Must start out empty
+ * @return true if the mission was planned and written, else false with the reason in result.error
+ * @see planMission
+ */
+bool runMission(const PlannerConfig &config, bool naive, MissionResult &result)
+{
+    float_type longitude = 0, latitude = 0;
+    std::vector<PointRecord> searchPoints; // Records read from the search grid file
+    std::vector<PointRecord> boundsPoints; // Records read from the boundary points file
+    std::vector<PointRecord> missionPoints; // Records read from the mission file
+    Polygon searchArea; // The search grid polygon
+    Polygon boundary; // The boundary polygon
+    Coord lastMissionPoint; // The coordinate the drone will be in before pathing to the search grid
+    PathStream path; // The search path, generated as it is written out
+    WaypointWriter outFile(config.outFile);
+    {
+        PROFILE_SCOPE(PHASE_PARSE);
+        if (!readPoints(config.missionFile, true, missionPoints))
+        {
+            result.error = "Could not read mission file.";
+            return false;
+        }
+        if (!readPoints(config.searchFile, false, searchPoints) || searchPoints.empty())
+        {
+            result.error = "Could not read search grid file.";
+            return false;
+        }
+        if (!readPoints(config.boundsFile, false, boundsPoints))
+        {
+            result.error = "Could not read boundary points file.";
+            return false;
+        }
+    }
+    if (!outFile.good())
+    {
+        result.error = "Could not create output file.";
+        return false;
+    }
+
+    // Convert the search grid
+    // Use the first search grid coordinate read as the origin point of our Cartesian system
+    const LocalFrame frame(toRadians(searchPoints[0].longitude), toRadians(searchPoints[0].latitude)); // Computes the basis vectors
+    std::vector<float_type> longitudes, latitudes; // Scratch arrays for batch conversion
+    {
+        PROFILE_SCOPE(PHASE_CONVERT);
+        toCoords(frame, searchPoints, searchArea.v, longitudes, latitudes);
+        searchArea.v[0] = Coord(0, 0); // Treat the first coordinate read as the origin
+        if (clockwise(searchArea.v)) // Ensure points are in counter-clockwise order
+            std::reverse(searchArea.v.begin(), searchArea.v.end());
+
+        // Convert the boundary
+        toCoords(frame, boundsPoints, boundary.v, longitudes, latitudes);
+        if (clockwise(boundary.v))
+            std::reverse(boundary.v.begin(), boundary.v.end());
+    }
+    BoundaryIndex boundaryIndex(boundary, config.radius); // Shared by every transit query in this run
+
+    {
+        PROFILE_SCOPE(PHASE_WRITE);
+        // Duplicate the mission points into our output file
+        for (size_t k = 0; k < missionPoints.size(); ++k)
+        {
+            latitude = toRadians(missionPoints[k].latitude);
+            longitude = toRadians(missionPoints[k].longitude);
+            outFile.write(toDegrees(latitude), toDegrees(longitude), (int) missionPoints[k].altitude);
+        }
+    }
+    lastMissionPoint = frame.toCoord(longitude, latitude);
+
+    // Generate paths
+    path = cachedPathStream(searchArea, naive, &boundaryIndex, config);
+    path.boundary = &boundaryIndex; // Also routes the naive path's entry from the last mission point
+    path.setStart(lastMissionPoint);
+
+    // Write output
+    // Waypoints are pulled from the stream and converted a fixed size chunk at a time
+    const size_t chunkSize = 256;
+    Coord waypoints[chunkSize];
+    Coord last = lastMissionPoint;
+    longitudes.resize(chunkSize);
+    latitudes.resize(chunkSize);
+    size_t n;
+    {
+        PROFILE_SCOPE(PHASE_WRITE);
+        do
+        {
+            n = 0;
+            while (n < chunkSize && path.next(waypoints[n]))
+                ++n;
+            frame.toGPSBatch(waypoints, n, &longitudes[0], &latitudes[0]);
+            for (size_t k = 0; k < n; ++k)
+            {
+                outFile.write(toDegrees(latitudes[k]), toDegrees(longitudes[k]), config.altitude);
+                result.pathLength += distance(last, waypoints[k]);
+                last = waypoints[k];
+            }
+            result.waypoints += n;
+        } while (n == chunkSize);
+        if (path.failed) // Leave no partial plan behind for the drone to fly
+        {
+            outFile.discard();
+            std::remove(config.outFile.c_str());
+            result.error = "No route between search waypoints stays inside the boundary.";
+            return false;
+        }
+        outFile.flush();
+    }
+    return true;
+}
+
+/**
+ * @brief Read a mission's point files, plan its search path and write the mission and search waypoints out.
+ * @param config the files and parameters of the mission
+ * @param naive true to use naive path generation with no decomposition
+ * @param result stores the outcome. The runtime is stored whether or not the mission was planned
+ * @return true if the mission was planned and written, else false with the reason in result.error
+ * @see MissionResult
+ */
+bool planMission(const PlannerConfig &config, bool naive, MissionResult &result)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    result = MissionResult();
+    bool planned = runMission(config, naive, result);
+    result.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return planned;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file Parser.cpp
+ * @brief Parser for the mission, search grid and boundary point files.
+ * Each file is a list of comma separated records of an ordinal number, latitude and longitude in degrees,
+ * followed by an altitude for mission files. Files are memory mapped and tokenized in place so there is no
+ * limit on the length of a token or line.
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <iostream>
+#include <charconv>
+#include <system_error>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Config.h"
+
+/**
+ * @brief A single record read from a point file.
+ */
+struct PointRecord
+{
+    /**
+     * @brief The ordinal number of the point.
+     */
+    int ordinal;
+    /**
+     * @brief The latitude in degrees.
+     */
+    float_type latitude;
+    /**
+     * @brief The longitude in degrees.
+     */
+    float_type longitude;
+    /**
+     * @brief The altitude in feet. Only present in mission files, else 0.
+     */
+    float_type altitude;
+
+    PointRecord(): ordinal(0), latitude(0), longitude(0), altitude(0)
+    {}
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * The mapping is released when the object is destroyed.
+ */
+struct MappedFile
+{
+    /**
+     * @brief Pointer to the first byte of the file or NULL if the file is empty or could not be opened.
+     */
+    const char *data;
+    /**
+     * @brief The size of the file in bytes.
+     */
+    size_t size;
+    /**
+     * @brief Whether the file was opened successfully.
+     */
+    bool ok;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+
+    /**
+     * @brief Map a file into memory.
+     * @param path path of the file
+     */
+    MappedFile(const std::string &path): data(NULL), size(0), ok(false)
+    {
+#ifdef _WIN32
+        mapping = NULL;
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize))
+            return;
+        size = (size_t)fileSize.QuadPart;
+        if (size == 0) // Empty files cannot be mapped
+        {
+            ok = true;
+            return;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+            return;
+        data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ok = data != NULL;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0)
+        {
+            size = (size_t)info.st_size;
+            if (size == 0) // Empty files cannot be mapped
+                ok = true;
+            else
+            {
+                void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr != MAP_FAILED)
+                {
+                    data = (const char *)addr;
+                    ok = true;
+                }
+            }
+        }
+        close(fd); // The mapping stays valid after the descriptor is closed
+#endif
+    }
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (data != NULL)
+            UnmapViewOfFile(data);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (data != NULL)
+            munmap((void *)data, size);
+#endif
+    }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+/**
+ * @brief Parse the next comma separated number from a buffer.
+ * Whitespace around the number is skipped.
+ * @param curr the position to start from. Stores the position after the number and its separator
+ * @param end the end of the buffer
+ * @param value stores the number
+ * @return true if a number was read, else false
+ */
+bool parseField(const char *&curr, const char *end, float_type &value)
+{
+    while (curr < end && (*curr == ' ' || *curr == '\t' || *curr == '\r' || *curr == '\n'))
+        ++curr;
+    if (curr < end && *curr == '+') // from_chars does not accept a leading plus sign
+        ++curr;
+    std::from_chars_result result = std::from_chars(curr, end, value);
+    if (result.ec != std::errc())
+        return false;
+    curr = result.ptr;
+    while (curr < end && (*curr == ' ' || *curr == '\t' || *curr == '\r' || *curr == '\n'))
+        ++curr;
+    if (curr < end)
+    {
+        if (*curr != ',')
+            return false;
+        ++curr;
+    }
+    return true;
+}
+
+/**
+ * @brief Read every record from a point file.
+ * @param path path of the file
+ * @param hasAltitude true if each record ends with an altitude field as in mission files
+ * @param points stores the records in file order
+ * @return true if the file was read and every record was complete, else false
+ * @see PointRecord
+ */
+bool readPoints(const std::string &path, bool hasAltitude, std::vector<PointRecord> &points)
+{
+    MappedFile file(path);
+    if (!file.ok)
+        return false;
+    const char *curr = file.data;
+    const char *end = file.data + file.size;
+    const unsigned int numFields = hasAltitude ? 4 : 3;
+    // Size the result up front from the number of separators so no reallocation happens while parsing
+    size_t numSeparators = 0;
+    for (const char *c = curr; c < end; ++c)
+        if (*c == ',')
+            ++numSeparators;
+    points.clear();
+    points.reserve(numSeparators / numFields + 1);
+    float_type fields[4];
+    while (true)
+    {
+        while (curr < end && (*curr == ' ' || *curr == '\t' || *curr == '\r' || *curr == '\n'))
+            ++curr;
+        if (curr == end) // Trailing whitespace after the last record
+            break;
+        for (unsigned int i = 0; i < numFields; ++i)
+        {
+            if (!parseField(curr, end, fields[i]))
+            {
+                std::cout << "Error: Malformed record " << points.size() + 1 << " in " << path << '\n';
+                return false;
+            }
+        }
+        PointRecord point;
+        point.ordinal = (int)fields[0];
+        point.latitude = fields[1];
+        point.longitude = fields[2];
+        if (hasAltitude)
+            point.altitude = fields[3];
+        points.push_back(point);
+    }
+    return true;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file PlanCache.cpp
+ * @brief On disk cache of planned search paths.
+ * A plan is the sweep legs and start state of every subregion in traversal order, which is everything
+ * a PathStream needs before the transits are routed, followed by the subregions each one shares an edge with
+ * so a plan loaded from the cache can still be resumed. Each plan is stored in its own binary file named
+ * after a 64-bit FNV-1a hash of its key, the search polygon's vertices in the local frame along with
+ * the parameters that affect decomposition, traversal and ordering. The whole key is also stored at the
+ * start of the file and compared on load so a hash collision is only a miss. Files are in the native
+ * byte order and float_type width and are meant to be reused on the machine that wrote them.
+ * @see PathStream
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "Polygon.cpp"
+#include "Parser.cpp"
+
+/**
+ * @brief Identifies plan cache files. Bump the last character when the layout changes.
+ */
+#define PLAN_CACHE_MAGIC "SPC2"
+
+/**
+ * @brief Append the raw bytes of a value to a buffer.
+ * @param buffer the buffer
+ * @param value the value
+ */
+template <typename T>
+void appendBytes(std::vector<char> &buffer, const T &value)
+{
+    const char *bytes = (const char *)&value;
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * @brief Read the raw bytes of a value from a buffer.
+ * @param curr the position to read from. Stores the position after the value
+ * @param end the end of the buffer
+ * @param value stores the value
+ * @return true if the buffer held the whole value, else false
+ */
+template <typename T>
+bool readBytes(const char *&curr, const char *end, T &value)
+{
+    if ((size_t)(end - curr) < sizeof(T))
+        return false;
+    memcpy(&value, curr, sizeof(T));
+    curr += sizeof(T);
+    return true;
+}
+
+/**
+ * @brief Serialize the key of a plan.
+ * Negative zeros are written as positive zeros so equal polygons have equal keys.
+ * @param p the search polygon in the local frame
+ * @param naive whether the plan uses naive path generation
+ * @param config supplies the offset, radius and correction
+ * @param key stores the serialized key
+ */
+void planKey(const Polygon &p, bool naive, const PlannerConfig &config, std::vector<char> &key)
+{
+    key.clear();
+    key.insert(key.end(), PLAN_CACHE_MAGIC, PLAN_CACHE_MAGIC + 4);
+    appendBytes(key, (uint32_t)sizeof(float_type));
+    appendBytes(key, (uint32_t)naive);
+    appendBytes(key, (uint32_t)BRUTE_FORCE_MAX);
+    appendBytes(key, (uint32_t)HELD_KARP_MAX);
+    appendBytes(key, (uint32_t)JOINT_TRAVERSAL_MAX);
+    appendBytes(key, (float_type)(config.offset + 0.0));
+    appendBytes(key, (float_type)(config.radius + 0.0));
+    appendBytes(key, (float_type)(config.correction + 0.0));
+    appendBytes(key, (uint64_t)p.v.size());
+    for (size_t i = 0; i < p.v.size(); ++i)
+    {
+        appendBytes(key, (float_type)(p.v[i].x + 0.0));
+        appendBytes(key, (float_type)(p.v[i].y + 0.0));
+    }
+}
+
+/**
+ * @brief Get the path of the cache file for a key.
+ * @param dir the cache directory
+ * @param key the serialized key
+ * @return the directory followed by the key's hash in hex
+ */
+std::string planPath(const std::string &dir, const std::vector<char> &key)
+{
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    for (size_t i = 0; i < key.size(); ++i)
+    {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.plan", (unsigned long long)hash);
+    if (dir.empty() || dir[dir.size() - 1] == '/' || dir[dir.size() - 1] == '\\')
+        return dir + name;
+    return dir + '/' + name;
+}
+
+/**
+ * @brief Load a cached plan.
+ * @param dir the cache directory
+ * @param key the serialized key of the plan
+ * @param stream stores the subregions of the plan
+ * @return true if a plan with the same key was read, else false
+ */
+bool loadPlan(const std::string &dir, const std::vector<char> &key, PathStream &stream)
+{
+    MappedFile file(planPath(dir, key));
+    if (!file.ok || file.size < key.size() || memcmp(file.data, &key[0], key.size()) != 0)
+        return false;
+    const char *curr = file.data + key.size();
+    const char *end = file.data + file.size;
+    uint64_t numRegions;
+    if (!readBytes(curr, end, numRegions))
+        return false;
+    PathStream loaded;
+    for (uint64_t i = 0; i < numRegions; ++i)
+    {
+        uint32_t state;
+        uint64_t numLegs;
+        if (!readBytes(curr, end, state) || state > END_V2 || !readBytes(curr, end, numLegs))
+            return false;
+        std::vector<Edge> legs;
+        legs.reserve(std::min<uint64_t>(numLegs, (end - curr) / (4 * sizeof(float_type)))); // Do not trust the count before reading
+        for (uint64_t j = 0; j < numLegs; ++j)
+        {
+            Coord v1, v2;
+            if (!readBytes(curr, end, v1.x) || !readBytes(curr, end, v1.y) || !readBytes(curr, end, v2.x) || !readBytes(curr, end, v2.y))
+                return false;
+            legs.push_back(Edge(v1, v2)); // Recomputes the line coefficients
+        }
+        loaded.addSubregion(std::move(legs), (State)state);
+    }
+    uint64_t numAdjacency;
+    if (!readBytes(curr, end, numAdjacency) || (numAdjacency != 0 && numAdjacency != numRegions))
+        return false;
+    loaded.adjacency.resize(numAdjacency);
+    for (uint64_t i = 0; i < numAdjacency; ++i)
+    {
+        uint32_t numAdjacent;
+        if (!readBytes(curr, end, numAdjacent))
+            return false;
+        loaded.adjacency[i].reserve(std::min<uint64_t>(numAdjacent, (end - curr) / sizeof(uint32_t)));
+        for (uint32_t j = 0; j < numAdjacent; ++j)
+        {
+            uint32_t adjacent;
+            if (!readBytes(curr, end, adjacent) || adjacent >= numRegions)
+                return false;
+            loaded.adjacency[i].push_back(adjacent);
+        }
+    }
+    if (curr != end)
+        return false;
+    stream.legs = std::move(loaded.legs);
+    stream.states = std::move(loaded.states);
+    stream.adjacency = std::move(loaded.adjacency);
+    return true;
+}
+
+/**
+ * @brief Save a plan to the cache.
+ * The file is written under a temporary name and then renamed so readers never see a partial plan.
+ * The temporary name includes the process and thread ids so planners sharing the cache directory never write the same file.
+ * @param dir the cache directory. Must already exist
+ * @param key the serialized key of the plan
+ * @param stream the plan. Only its subregions are saved
+ * @return true if the plan was saved, else false
+ */
+bool savePlan(const std::string &dir, const std::vector<char> &key, const PathStream &stream)
+{
+    std::vector<char> buffer(key);
+    appendBytes(buffer, (uint64_t)stream.legs.size());
+    for (size_t i = 0; i < stream.legs.size(); ++i)
+    {
+        appendBytes(buffer, (uint32_t)stream.states[i]);
+        appendBytes(buffer, (uint64_t)stream.legs[i].size());
+        for (size_t j = 0; j < stream.legs[i].size(); ++j)
+        {
+            appendBytes(buffer, stream.legs[i][j].v1.x);
+            appendBytes(buffer, stream.legs[i][j].v1.y);
+            appendBytes(buffer, stream.legs[i][j].v2.x);
+            appendBytes(buffer, stream.legs[i][j].v2.y);
+        }
+    }
+    appendBytes(buffer, (uint64_t)stream.adjacency.size());
+    for (size_t i = 0; i < stream.adjacency.size(); ++i)
+    {
+        appendBytes(buffer, (uint32_t)stream.adjacency[i].size());
+        for (size_t j = 0; j < stream.adjacency[i].size(); ++j)
+            appendBytes(buffer, (uint32_t)stream.adjacency[i][j]);
+    }
+    std::string path = planPath(dir, key);
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = getpid();
+#endif
+    std::string temp = path + '.' + std::to_string(pid) + '.' + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(temp.c_str(), std::ios::binary);
+        if (!file.write(&buffer[0], buffer.size()))
+        {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str()); // Renaming over an existing file fails on Windows
+#endif
+    if (std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Plan a search path, reusing the plan cached for the same polygon and parameters if there is one.
+ * @param p the search polygon in the local frame
+ * @param naive true to use naive path generation with no decomposition
+ * @param boundary if not null, transitions between subregions are routed to stay inside this boundary
+ * @param config supplies the parameters and the cache directory. Caching is skipped if config.cacheDir is empty
+ * @param memo if not null, a plan that is not cached reuses what it can of the previous plan
+ * @return the planned search path
+ * @see searchPathStream naivePathStream PlanMemo
+ */
+PathStream cachedPathStream(const Polygon &p, bool naive, const BoundaryIndex *boundary, const PlannerConfig &config, PlanMemo *memo = NULL)
+{
+    std::vector<char> key;
+    PathStream stream(boundary);
+    if (!config.cacheDir.empty())
+    {
+        planKey(p, naive, config, key);
+        if (loadPlan(config.cacheDir, key, stream))
+            return stream;
+    }
+    stream = naive ? naivePathStream(p, config) : searchPathStream(p, boundary, config, memo);
+    stream.boundary = boundary;
+    if (!config.cacheDir.empty() && !savePlan(config.cacheDir, key, stream))
+        std::cout << "Warning: Could not write plan cache file " << planPath(config.cacheDir, key) << '\n';
+    return stream;
+}
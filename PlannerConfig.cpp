@@ -0,0 +1,208 @@
+/**
+ * @file PlannerConfig.cpp
+ * @brief Runtime configuration for the planner.
+ * Defaults come from the #define statements in Config.h and can be overridden from a key=value file or
+ * from command line flags without recompiling.
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include "Config.h"
+
+/**
+ * @brief Parameters that control a planning run.
+ * Recognized keys are out_file, mission_file, bounds_file, search_file, profile_file, trace_file, batch_file, socket_file, cache_dir, altitude, radius, offset and correction.
+ */
+struct PlannerConfig
+{
+    /**
+     * @brief The resulting search path will be written to this file.
+     * @see OUT_FILE
+     */
+    std::string outFile;
+    /**
+     * @brief The initial mission points are read from this file.
+     * @see MISSION_FILE
+     */
+    std::string missionFile;
+    /**
+     * @brief The coordinates of the boundary polygon are read from this file.
+     * @see BOUNDS_FILE
+     */
+    std::string boundsFile;
+    /**
+     * @brief The coordinates of the search area are read from this file.
+     * @see SEARCH_FILE
+     */
+    std::string searchFile;
+    /**
+     * @brief If not empty, a JSON report of the time spent in each phase is written to this file.
+     * @see Profiler PROFILE
+     */
+    std::string profileFile;
+    /**
+     * @brief If not empty, a Chrome trace of the spans recorded during the run is written to this file.
+     * @see Profiler PROFILE
+     */
+    std::string traceFile;
+    /**
+     * @brief If not empty, every mission listed in this manifest file is planned instead of the single mission above.
+     * @see runBatch
+     */
+    std::string batchFile;
+    /**
+     * @brief If not empty, the planner runs as a daemon answering requests on a Unix domain socket at this path.
+     * @see PlanDaemon
+     */
+    std::string socketFile;
+    /**
+     * @brief If not empty, planned search paths are cached in this directory and reused by later runs.
+     * @see cachedPathStream
+     */
+    std::string cacheDir;
+    /**
+     * @brief The output altitude of the drone for the search path in feet.
+     * @see ALTITUDE
+     */
+    int altitude;
+    /**
+     * @brief The turn radius of the drone in meters.
+     * @see RADIUS
+     */
+    float_type radius;
+    /**
+     * @brief The spacing between each sweep line in meters.
+     * @see OFFSET
+     */
+    float_type offset;
+    /**
+     * @brief Distance search path waypoints are scaled inward to avoid exiting the boundary.
+     * @see CORRECTION
+     */
+    float_type correction;
+
+    /**
+     * @brief Construct the configuration with the defaults from Config.h.
+     */
+    PlannerConfig(): outFile(OUT_FILE), missionFile(MISSION_FILE), boundsFile(BOUNDS_FILE), searchFile(SEARCH_FILE),
+                     altitude(ALTITUDE), radius(RADIUS), offset(OFFSET), correction(CORRECTION)
+    {}
+    /**
+     * @brief Set a single parameter by name.
+     * @param key name of the parameter
+     * @param value the value as text
+     * @return true if the key is known and the value is valid, else false
+     */
+    bool set(const std::string &key, const std::string &value)
+    {
+        char *end = NULL;
+        double number = strtod(value.c_str(), &end);
+        bool isNumber = !value.empty() && *end == '\0';
+        if (key == "out_file")
+            outFile = value;
+        else if (key == "mission_file")
+            missionFile = value;
+        else if (key == "bounds_file")
+            boundsFile = value;
+        else if (key == "search_file")
+            searchFile = value;
+        else if (key == "profile_file")
+            profileFile = value;
+        else if (key == "trace_file")
+            traceFile = value;
+        else if (key == "batch_file")
+            batchFile = value;
+        else if (key == "socket_file")
+            socketFile = value;
+        else if (key == "cache_dir")
+            cacheDir = value;
+        else if (!isNumber) // Every remaining parameter is numeric
+            return false;
+        else if (key == "altitude")
+            altitude = (int)number;
+        else if (key == "radius" && number > 0)
+            radius = number;
+        else if (key == "offset" && number > 0)
+            offset = number;
+        else if (key == "correction" && number >= 0)
+            correction = number;
+        else
+            return false;
+        return true;
+    }
+    /**
+     * @brief Read parameters from a file of key=value lines. Blank lines and lines starting with # are ignored.
+     * @param path path of the file
+     * @return true if the file was read and every line was valid, else false
+     */
+    bool load(const std::string &path)
+    {
+        std::ifstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "Error: Could not open config file " << path << '\n';
+            return false;
+        }
+        std::string line;
+        unsigned int lineNum = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNum;
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::string::size_type eq = line.find('=');
+            if (eq == std::string::npos || !set(line.substr(0, eq), line.substr(eq + 1)))
+            {
+                std::cout << "Error: Invalid config line " << lineNum << " in " << path << ": " << line << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+    /**
+     * @brief Read parameters from command line flags of the form --key=value.
+     * The flag --config=path loads a config file at that point so later flags override it.
+     * @param argc number of arguments
+     * @param argv the arguments
+     * @param positional stores the arguments that are not flags
+     * @return true if every flag was valid, else false
+     */
+    bool parseArgs(int argc, char **argv, std::vector<std::string> &positional)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            if (arg.compare(0, 2, "--") != 0)
+            {
+                positional.push_back(arg);
+                continue;
+            }
+            std::string::size_type eq = arg.find('=');
+            if (eq == std::string::npos)
+            {
+                std::cout << "Error: Expected --key=value but got " << arg << '\n';
+                return false;
+            }
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+            if (key == "config")
+            {
+                if (!load(value))
+                    return false;
+            }
+            else if (!set(key, value))
+            {
+                std::cout << "Error: Invalid option " << arg << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+};
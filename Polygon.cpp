@@ -19,8 +19,17 @@
 #include <assert.h>
 #include <cfloat>
 #include <utility>
+#include <queue>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+#include <map>
+#include <mutex>
 #include "Graph.cpp"
+#include "ThreadPool.cpp"
 #include "Config.h"
+#include "PlannerConfig.cpp"
+#include "Profiler.cpp"
 
 /**
  * @brief Approximate value for pi.
@@ -49,7 +58,12 @@ struct Coord; // A 2-D coordinate. Also used to represent the positional vector
 struct Edge; // An edge consisting of 2 coordinates.
 struct Span; // A vertex-edge span of a polygon.
 struct Polygon; // A polygon consisting of a list of coordinates in CCW order.
+struct PolygonView; // A polygon formed by index ranges of another polygon's vertices.
 struct Node; // Node for the undirected weighted graph.
+struct SharedEdgeIndex; // Hash index from each edge to the subregions that have it.
+struct BoundaryIndex; // Precomputed boundary geometry shared by transit queries.
+struct PathStream; // Yields the waypoints of a planned search path one at a time.
+struct PlanMemo; // Results of the previous plan reused when the search polygon is edited.
 
 /**
  * @brief Find the distance between two vertices.
@@ -67,23 +81,71 @@ float_type distance(const Coord &v1, const Coord &v2);
  * @see Coord Edge float_type
  */
 float_type distance(const Coord &v, const Edge &e);
-// Helper calculation for finding the width of a polygon.
-//inline float_type deltaDistance(const Polygon &p, int i, int j);
 /**
- * @brief Find the width of a convex polygon.
+ * @brief Find the distance between a vertex and the closest point of a line segment.
+ * @param v the vertex
+ * @param e the line segment as an edge
+ * @return the distance between the vertex and the segment
+ * @see Coord Edge float_type
+ */
+float_type segmentDistance(const Coord &v, const Edge &e);
+/**
+ * @brief Find the distance between the closest points of two line segments.
+ * @param e1 the first line segment as an edge
+ * @param e2 the second line segment as an edge
+ * @return the distance between the segments, 0 if they intersect
+ * @see Edge float_type
+ */
+float_type segmentDistance(const Edge &e1, const Edge &e2);
+/**
+ * @brief Find the width of a polygon.
+ * For every edge the span to the farthest vertex is found with rotating calipers over the convex hull.
+ * This is O(n) for convex polygons and O(n log n) otherwise. The result is cached on the polygon.
  * @param p the polygon
- * @return the width of the polygon as a span
- * @see Span Polygon
+ * @return the minimum length span over all edges of the polygon
+ * @see Span Polygon getWidthNaive
  */
 Span getWidth(const Polygon &p);
+/**
+ * @brief Find the width of a polygon view without copying its vertices.
+ * @param p the polygon view
+ * @return the minimum length span over all edges of the polygon
+ * @see Span PolygonView
+ */
+Span getWidth(const PolygonView &p);
+/**
+ * @brief Rotating calipers implementation shared by the getWidth overloads.
+ * @param p the polygon or polygon view
+ * @return the minimum length span over all edges of the polygon
+ * @see getWidth
+ */
+template <typename P>
+Span computeWidth(const P &p);
+/**
+ * @brief Find the width of a polygon by checking every edge against every vertex in O(n^2).
+ * Kept as the reference implementation for getWidth.
+ * @param p the polygon or polygon view
+ * @return the minimum length span over all edges of the polygon
+ * @see Span Polygon getWidth
+ */
+template <typename P>
+Span getWidthNaive(const P &p);
+/**
+ * @brief Compute the convex hull of a set of points.
+ * @param v the points
+ * @param hull stores the vertices of the hull in CCW order with collinear points removed
+ * @see Coord
+ */
+void convexHull(const std::vector<Coord> &v, std::vector<Coord> &hull);
 /**
  * @brief Determine if a given vertex of a polygon is concave.
- * @param p the polygon
+ * @param p the polygon or polygon view
  * @param i index of the vertex
  * @return true if the vertex is concave, else false
- * @see Polygon
+ * @see Polygon PolygonView
  */
-bool isConcave(const Polygon &p, int i);
+template <typename P>
+bool isConcave(const P &p, int i);
 /**
  * @brief Splits a polygon into two along an edge.
  * @param p the polygon
@@ -95,14 +157,52 @@ bool isConcave(const Polygon &p, int i);
  * @see Polygon
  */
 void split(const Polygon &p, int v1, int v2, Polygon &p1, Polygon &p2);
+/**
+ * @brief Splits a polygon into two views along an edge without copying any vertices.
+ * @param p the polygon
+ * @param v1 first vertex of edge
+ * @param v2 second vertex of edge
+ * @param p1 stores the first resulting polygon view
+ * @param p2 stores the second resulting polygon view
+ * @return resulting polygon views are stored in p1 and p2
+ * @see Polygon PolygonView split
+ */
+void splitView(const Polygon &p, int v1, int v2, PolygonView &p1, PolygonView &p2);
+/**
+ * @brief Check that splitting a polygon at a concave vertex stays inside its interior angle without crossing
+ * any of its edges and compute the widths of the result.
+ * @param p the polygon
+ * @param c index of the concave vertex
+ * @param j index of the other vertex of the split
+ * @param width1 stores the width of the first resulting polygon if the split is valid
+ * @param width2 stores the width of the second resulting polygon if the split is valid
+ * @param checkAngle false to skip the interior angle test and only require the split to stay inside the polygon
+ * @return true if the split is valid, else false
+ * @see Polygon splitView getWidth
+ */
+bool scoreSplit(const Polygon &p, unsigned int c, unsigned int j, Span &width1, Span &width2, bool checkAngle = true);
 /**
  * @brief Decompose a concave polygon into multiple convex polygons.
+ * Candidate splits are scored in parallel when there are at least PARALLEL_MIN_CANDIDATES of them and
+ * the two halves of polygons with at least PARALLEL_MIN_VERTICES vertices are decomposed in parallel.
+ * The order of the resulting list does not depend on the number of threads. If the interior angle test
+ * rejects every split of a concave polygon, any split that stays inside the polygon is used instead.
  * @param p the polygon
  * @param l stores the resulting list of polygons
+ * @param memo if not null, pieces of p that were decomposed by the previous plan are reused instead of split again
  * @result resulting polygons are stored in l
- * @see Polygon
+ * @see Polygon PlanMemo
+ */
+void decompose(const Polygon &p, std::list<Polygon> &l, PlanMemo *memo = NULL);
+/**
+ * @brief Split a polygon at its best split and decompose the two halves.
+ * @param p the polygon
+ * @param l stores the resulting list of polygons
+ * @param memo passed on to the decomposition of the halves
+ * @param halves if not null, stores the vertices of the two halves p was split into. Left empty if p is not split
+ * @see decompose
  */
-void decompose(const Polygon &p, std::list<Polygon> &l);
+void decomposeSplit(const Polygon &p, std::list<Polygon> &l, PlanMemo *memo, std::vector<std::vector<Coord> > *halves = NULL);
 /**
  * @brief Merge two polygons by their shared edge given the edge's index in each polygon and return the result
  * @param p1 the first polygon
@@ -115,10 +215,12 @@ void decompose(const Polygon &p, std::list<Polygon> &l);
 Polygon merge(const Polygon &p1, const Polygon &p2, unsigned int i, unsigned int j);
 /**
  * @brief Combine applicable subregions after decomposition.
+ * Adjacent subregions are found through a SharedEdgeIndex that is built once and updated as regions merge.
  * @param l list of decomposed polygon subregions
- * @see Polygon decompose
+ * @param adjacency if not null, stores the indices of the subregions adjacent to each resulting subregion in list order
+ * @see Polygon decompose SharedEdgeIndex
  */
-void mergeSubregions(std::list<Polygon> &l);
+void mergeSubregions(std::list<Polygon> &l, std::vector<std::vector<unsigned int> > *adjacency = NULL);
 /**
  * @brief Calculate the cross product of two vectors represented as coordinates.
  * @param c1 the first vector as a coordinate
@@ -139,18 +241,20 @@ inline float_type cross(const Coord &c1, const Coord &c2);
  */
 bool intersection(const Edge &e1, const Edge &e2, Coord &intersect);
 /**
- * @brief Traverse a convex polygon and store the waypoints in a list as Edges.
+ * @brief Traverse a convex polygon and append the waypoints to a vector as Edges.
  * @param p the polygon to traverse
  * @param waypoints list to store the traversal
- * @see Polygon Edge
+ * @param config supplies the sweep spacing, correction and turn radius
+ * @see Polygon Edge PlannerConfig
  */
-void traverse(const Polygon &p, std::list<Edge> &waypoints);
+void traverse(const Polygon &p, std::vector<Edge> &waypoints, const PlannerConfig &config = PlannerConfig());
 /**
  * @brief Helper function to compute the adjacencies and weights of the graph.
  * @param g the graph to compute
- * @see Graph
+ * @param adjacency if not null, the subregions adjacent to each node as given by mergeSubregions(). Else they are found with a SharedEdgeIndex
+ * @see Graph mergeSubregions
  */
-void computeGraph(Graph<Node, float_type> &g);
+void computeGraph(Graph<Node, float_type> &g, const std::vector<std::vector<unsigned int> > *adjacency = NULL);
 /**
  * @brief Compute the total length of a graph traversal.
  * @param g the weighted graph
@@ -161,25 +265,119 @@ void computeGraph(Graph<Node, float_type> &g);
 float_type traversalLength(const Graph<Node, float_type> &g, std::list<unsigned int> &path);
 /**
  * @brief Compute the minimum cost traversal for the weighted graph.
+ * Uses brute force for up to BRUTE_FORCE_MAX nodes, Held-Karp for up to HELD_KARP_MAX nodes, and a greedy heuristic beyond that.
  * @param g the weighted graph
  * @return the minimum cost traversal as a list of node indeces
  * @see Graph
  */
 std::list<unsigned int> minTraversal(Graph<Node, float_type> &g);
+/**
+ * @brief Compute the minimum cost traversal by trying every permutation of nodes.
+ * @param g the weighted graph
+ * @return the minimum cost traversal as a list of node indeces
+ * @see Graph minTraversal
+ */
+std::list<unsigned int> bruteForceTraversal(Graph<Node, float_type> &g);
+/**
+ * @brief Compute the minimum cost traversal using the Held-Karp bitmask dynamic program in O(n^2 * 2^n).
+ * @param g the weighted graph
+ * @return the minimum cost traversal as a list of node indeces
+ * @see Graph minTraversal
+ */
+std::list<unsigned int> heldKarpTraversal(Graph<Node, float_type> &g);
+/**
+ * @brief Compute an approximate minimum cost traversal using nearest neighbor construction and 2-opt improvement.
+ * @param g the weighted graph
+ * @return an approximate minimum cost traversal as a list of node indeces
+ * @see Graph minTraversal
+ */
+std::list<unsigned int> greedyTraversal(Graph<Node, float_type> &g);
+/**
+ * @brief Get the first waypoint flown in a node's subregion for a given start state.
+ * @param n the node
+ * @param s the start state
+ * @return the entry waypoint, or the center of the subregion if it has no path
+ * @see Node State
+ */
+Coord entryPoint(const Node &n, State s);
+/**
+ * @brief Get the last waypoint flown in a node's subregion for a given start state.
+ * @param n the node
+ * @param s the start state
+ * @return the exit waypoint, or the center of the subregion if it has no path
+ * @see Node State
+ */
+Coord exitPoint(const Node &n, State s);
+/**
+ * @brief Index into the joint point distance table.
+ * @param n number of nodes in the graph
+ * @param i index of the node being left
+ * @param a start state of node i
+ * @param j index of the node being entered
+ * @param b start state of node j
+ * @return index of the distance from the exit of i in state a to the entry of j in state b
+ * @see jointDistances
+ */
+inline size_t jointIndex(unsigned int n, unsigned int i, State a, unsigned int j, State b);
+/**
+ * @brief Compute the distances between the joint points of every pair of nodes for every pair of start states.
+ * Transitions between non-adjacent subregions are penalized by INF.
+ * @param g the weighted graph
+ * @param table stores the n * n * 4 * 4 distances
+ * @see jointIndex
+ */
+void jointDistances(Graph<Node, float_type> &g, std::vector<float_type> &table);
 /**
  * @brief Determine the start states of each node along the traversal.
+ * The states minimize the total joint point distance for the given order.
  * @param path the traversal
  * @param g the weighted graph
  * @see State
  */
 void computeStates(std::list<unsigned int> &path, Graph<Node, float_type> &g);
+/**
+ * @brief Compute the traversal order and the start state of each node together as a generalized TSP.
+ * Exact for up to JOINT_TRAVERSAL_MAX nodes. Larger graphs use minTraversal() followed by computeStates().
+ * @param g the weighted graph with node paths already computed
+ * @param first if not negative, the traversal must start at this node. Only allowed for up to JOINT_TRAVERSAL_MAX nodes
+ * @return the traversal as a list of node indeces. Start states are stored in the nodes
+ * @see Graph State minTraversal computeStates
+ */
+std::list<unsigned int> jointTraversal(Graph<Node, float_type> &g, int first = -1);
+/**
+ * @brief Plans the search path for a polygon without generating its waypoints.
+ * Decomposition, subregion traversals and the traversal order are computed up front. Waypoints and the
+ * transitions between subregions are produced as the stream is read.
+ * @param p the polygon
+ * @param boundary if not null, transitions between subregions are routed to stay inside this boundary
+ * @param config the planning parameters
+ * @param memo if not null, the parts of the previous plan that p did not change are reused and the memo is updated for the next plan
+ * @return a stream of the search path waypoints
+ * @see PathStream searchPath PlanMemo
+ */
+PathStream searchPathStream(const Polygon &p, const BoundaryIndex *boundary = NULL, const PlannerConfig &config = PlannerConfig(), PlanMemo *memo = NULL);
 /**
  * @brief Generates the search path for a polygon.
  * @param p the polygon
- * @return the search path as a list of Coords
- * @see Coord
+ * @param boundary if not null, transitions between subregions are routed to stay inside this boundary
+ * @param config the planning parameters
+ * @return the search path as a vector of Coords, empty if a transition could not be routed inside the boundary
+ * @see Coord BoundaryIndex PlannerConfig
+ */
+std::vector<Coord> searchPath(const Polygon &p, const BoundaryIndex *boundary = NULL, const PlannerConfig &config = PlannerConfig());
+/**
+ * @brief Plans the rest of a search path that was interrupted part way through.
+ * The sweep legs already flown are dropped and the subregions left are ordered again from the current
+ * position, reusing their planned sweep legs instead of traversing them again. The subregion the drone
+ * stopped in keeps its remaining legs. The order is exact for up to JOINT_TRAVERSAL_MAX subregions left,
+ * larger plans keep their planned order and only have their start states solved again.
+ * @param plan the planned search path. Its read position is ignored
+ * @param completedLegs the number of sweep legs of the plan already flown
+ * @param position the current position, which the first transition is routed from
+ * @return a stream of the remaining search path waypoints, with the plan's boundary
+ * @see PathStream searchPathStream jointTraversal
  */
-std::list<Coord> searchPath(const Polygon &p);
+PathStream resumePathStream(const PathStream &plan, size_t completedLegs, const Coord &position);
 /**
  * @brief Determine if the list of coordinates are in clockwise order.
  * @param v the list of coordinates
@@ -188,30 +386,79 @@ std::list<Coord> searchPath(const Polygon &p);
  */
 bool clockwise(const std::vector<Coord> &v);
 /**
- * @brief Computes a path from one point to another that does not intersect the boundary polygon.
- * Assumes both points are inside the boundary polygon
+ * @brief Determine if a point lies inside a polygon.
+ * @param c the point
+ * @param p the polygon
+ * @return true if the point is inside, else false
+ * @see Coord Polygon
+ */
+bool inside(const Coord &c, const Polygon &p);
+/**
+ * @brief Determine if the straight line between two points stays inside the boundary polygon.
  * @param point1 the first point
  * @param point2 the second point
  * @param boundary the boundary polygon
- * @return the path as a list of Coords
+ * @return true if the line does not cross the boundary, else false
  * @see Coord Polygon
  */
-std::list<Coord> pathTo(const Coord &point1, const Coord &point2, const Polygon &boundary);
+bool visible(const Coord &point1, const Coord &point2, const Polygon &boundary);
+/**
+ * @brief Offset the concave vertices of the boundary polygon inward.
+ * Offset vertices that fall outside the boundary or end up closer than radius to any boundary edge are dropped.
+ * @param boundary the boundary polygon
+ * @param radius the distance to keep from the boundary edges
+ * @param verts stores the offset vertices
+ * @see Polygon
+ */
+void inflate(const Polygon &boundary, float_type radius, std::vector<Coord> &verts);
+/**
+ * @brief Computes a path from one point to another that stays inside the boundary polygon.
+ * Uses A* over the visibility graph of the boundary's concave vertices inflated by the turn radius.
+ * @param point1 the first point
+ * @param point2 the second point
+ * @param boundary the boundary polygon
+ * @param path stores the waypoints between point1 and point2, empty if the straight line is clear
+ * @param config supplies the turn radius kept from the boundary
+ * @return true if a route was found, else false and path is empty
+ * @see Coord Polygon PlannerConfig
+ */
+bool pathTo(const Coord &point1, const Coord &point2, const Polygon &boundary, std::vector<Coord> &path, const PlannerConfig &config = PlannerConfig());
+/**
+ * @brief Computes a path from one point to another that stays inside the boundary polygon.
+ * Reuses the precomputed boundary geometry so only the two end points need to be connected.
+ * @param point1 the first point
+ * @param point2 the second point
+ * @param index the precomputed boundary geometry
+ * @param path stores the waypoints between point1 and point2, empty if the straight line is clear
+ * @return true if a route was found, else false and path is empty
+ * @see Coord BoundaryIndex
+ */
+bool pathTo(const Coord &point1, const Coord &point2, const BoundaryIndex &index, std::vector<Coord> &path);
 /**
  * @brief Traverse the polygon using a simple parallel traversal.
  * @param p the polygon
  * @param waypoints stores the resulting waypoints of the traversal
+ * @param config supplies the sweep spacing and correction
  * @return resulting traversal is stored in waypoints
- * @see Polygon Edge
+ * @see Polygon Edge PlannerConfig
+ */
+void naiveTraverse(const Polygon &p, std::vector<Edge> &waypoints, const PlannerConfig &config = PlannerConfig());
+/**
+ * @brief Plans a search path for a polygon using naive traversal without generating its waypoints.
+ * @param p the polygon
+ * @param config the planning parameters
+ * @return a stream of the search path waypoints
+ * @see PathStream naivePath
  */
-void naiveTraverse(const Polygon &p, std::list<Edge> &waypoints);
+PathStream naivePathStream(const Polygon &p, const PlannerConfig &config = PlannerConfig());
 /**
  * @brief Generates a search path for a polygon using naive traversal.
  * @param p the polygon
- * @return the search path as a list of Coords
- * @see Coord Polygon naiveTraverse
+ * @param config the planning parameters
+ * @return the search path as a vector of Coords
+ * @see Coord Polygon naiveTraverse PlannerConfig
  */
-std::list<Coord> naivePath(const Polygon &p);
+std::vector<Coord> naivePath(const Polygon &p, const PlannerConfig &config = PlannerConfig());
 
 //============================================================
 // Structs
@@ -388,6 +635,11 @@ struct Span
      */
     Edge e;
 
+    /**
+     * @brief Default constructor.
+     */
+    Span()
+    {}
     /**
      * @brief Constructor
      */
@@ -429,20 +681,57 @@ struct Polygon
      * @see Coord
      */
     std::vector<Coord> v;
+    /**
+     * @brief Cached result of getWidth. Only valid if widthCached is true.
+     * @see getWidth Span
+     */
+    mutable Span width;
+    /**
+     * @brief Whether width holds the width of the current vertices.
+     * Call invalidate() after modifying v directly.
+     */
+    mutable bool widthCached;
 
+    /**
+     * @brief Default constructor.
+     */
+    Polygon(): widthCached(false)
+    {}
+    /**
+     * @brief Copy constructor. The cached width is copied along with the vertices.
+     * @param op the polygon to copy
+     */
+    Polygon(const Polygon &op): v(op.v), width(op.width), widthCached(op.widthCached)
+    {}
     /**
      * @brief Add a vertex to the polygon
      * @param vert the vertex to add
      * @see Coord
      */
     void addVert(Coord vert)
-    { v.push_back(vert); }
+    {
+        v.push_back(vert);
+        widthCached = false;
+    }
+    /**
+     * @brief Discard cached values after the vertices are modified directly.
+     */
+    void invalidate()
+    { widthCached = false; }
     /**
      * @brief Get the number of vertices in the polygon.
      * @return the number of vertices
      */
     unsigned int size() const
     { return v.size(); }
+    /**
+     * @brief Get a vertex of the polygon.
+     * @param i index of the vertex
+     * @return the vertex
+     * @see Coord
+     */
+    const Coord& vert(unsigned int i) const
+    { return v[i]; }
     /**
      * @brief Construct an edge of the polygon given the index of the first vertex.
      * @param i index of the first vertex
@@ -459,7 +748,7 @@ struct Polygon
      * @return true if adjacent and stores indeces in edgeIndex1 and edgeIndex2 if not null, else false and stores -1 in edgeIndex1 and edgeIndex2 if not null
      */
     bool adjacent(Polygon &p, int *edgeIndex1 = NULL, int *edgeIndex2 = NULL) const // Return true if p is adjacent and store the indeces for the edge in edgeIndex1 and 2 respectively. Else, return false and set indices to -1.
-    { // This is the O(nm) solution which should be good enough unless our polygons are crazy. If more speed is required, use a hashing solution for linear time complexity.
+    { // This is the O(nm) solution. Use SharedEdgeIndex to find the adjacencies of many polygons at once.
         for (unsigned int i = 0; i < v.size(); ++i)
         {
             Edge e1 = edge(i);
@@ -526,10 +815,79 @@ struct Polygon
     Polygon& operator=(const Polygon &op)
     {
         v = op.v;
+        width = op.width;
+        widthCached = op.widthCached;
         return *this;
     }
 };
 
+/**
+ * @brief A polygon formed by up to two index ranges of another polygon's vertices.
+ * Used to score candidate splits without copying vertices. The parent polygon must outlive the view.
+ * @see Polygon splitView
+ */
+struct PolygonView
+{
+    /**
+     * @brief The vertices of the parent polygon.
+     * @see Coord
+     */
+    const std::vector<Coord> *verts;
+    /**
+     * @brief The first range of parent vertex indeces [begin1, end1).
+     */
+    unsigned int begin1, end1;
+    /**
+     * @brief The second range of parent vertex indeces [begin2, end2) that follows the first. Empty if begin2 == end2.
+     */
+    unsigned int begin2, end2;
+
+    /**
+     * @brief Default constructor for an empty view.
+     */
+    PolygonView(): verts(NULL), begin1(0), end1(0), begin2(0), end2(0)
+    {}
+    /**
+     * @brief Construct a view over the given ranges of a polygon's vertices.
+     */
+    PolygonView(const Polygon &p, unsigned int b1, unsigned int e1, unsigned int b2 = 0, unsigned int e2 = 0):
+        verts(&p.v), begin1(b1), end1(e1), begin2(b2), end2(e2)
+    {}
+    /**
+     * @brief Get the number of vertices in the view.
+     * @return the number of vertices
+     */
+    unsigned int size() const
+    { return (end1 - begin1) + (end2 - begin2); }
+    /**
+     * @brief Get a vertex of the view.
+     * @param i index of the vertex within the view
+     * @return the vertex
+     * @see Coord
+     */
+    const Coord& vert(unsigned int i) const
+    { return (i < end1 - begin1) ? (*verts)[begin1 + i] : (*verts)[begin2 + i - (end1 - begin1)]; }
+    /**
+     * @brief Construct an edge of the view given the index of the first vertex.
+     * @param i index of the first vertex
+     * @return the corresponding edge
+     * @see Edge
+     */
+    Edge edge(unsigned int i) const
+    { return Edge(vert(i), vert((i + 1) % size())); }
+    /**
+     * @brief Copy the vertices of the view into a polygon.
+     * @param p stores the resulting polygon
+     * @see Polygon
+     */
+    void copyTo(Polygon &p) const
+    {
+        p.v.assign(verts->begin() + begin1, verts->begin() + end1);
+        p.v.insert(p.v.end(), verts->begin() + begin2, verts->begin() + end2);
+        p.invalidate();
+    }
+};
+
 /**
  * @brief Node class for weighted graph.
  * Consists of the search path for the polygon, a pointer to the polygon, and the start state
@@ -545,7 +903,7 @@ struct Node
      * @brief The traversal path for the associated polygon
      * @see Edge
      */
-    std::list<Edge> path;
+    std::vector<Edge> path;
     /**
      * @brief The start state of the traversal
      * @see State
@@ -554,182 +912,859 @@ struct Node
 
     /**
      * @brief Constructor
+     * @param poly pointer to the associated polygon
+     * @param waypoints the traversal path. Pass with std::move to avoid a copy
+     * @param state the start state
      */
-    Node(Polygon *poly = NULL, std::list<Edge> *waypoints = NULL, State state = START_V1)
-    {
-        p = poly;
-        if (waypoints != NULL)
-            path = *waypoints;
-        startState = state;
-    }
+    Node(Polygon *poly = NULL, std::vector<Edge> waypoints = std::vector<Edge>(), State state = START_V1): p(poly), path(std::move(waypoints)), startState(state)
+    {}
 };
 
-//============================================================
-// Functions
-//============================================================
-float_type distance(const Coord &v1, const Coord &v2) // Find the distance between two vertices
-{ return sqrt(pow((v2.y - v1.y), 2) + pow(v2.x - v1.x, 2)); }
-
-float_type distance(const Coord &v, const Edge &e) // Find the distance between a vertex and an edge
+/**
+ * @brief Hash index from each edge to the subregions that have it.
+ * Edges are keyed on their two end points in a canonical order so a shared edge hashes the same from both
+ * of the polygons it borders. Finding the neighbors of a region is then linear in its number of edges.
+ * Regions are identified by an id chosen by the caller.
+ * @see mergeSubregions computeGraph
+ */
+struct SharedEdgeIndex
 {
-    if (e.isVertical()) // Special case for distance from a perfectly vertical edge
-        return abs(e.v1.x - v.x);
-    float_type numer = abs((e.a * v.x) + (e.b * v.y) + e.c);
-    float_type denom = sqrt(e.a * e.a + e.b * e.b);
-    return numer / denom;
-}
+    /**
+     * @brief An edge with its end points in canonical order.
+     */
+    struct Key
+    {
+        Coord a, b;
 
-// inline float_type deltaDistance(const Polygon &p, int i, int j) // Helper calculation for finding antipodal vertices
-// { return (p.v[(i + 1) % p.size()].y - p.v[i].y) * (p.v[(j + 1) % p.size()].x - p.v[j].x) - (p.v[(i + 1) % p.size()].x - p.v[i].x) * (p.v[(j + 1) % p.size()].y - p.v[j].y); }
-
-// Span getWidth(const Polygon &p) // Find the width of a convex polygon in O(n)
-// { // This is bugged and incorrect. Because the polygons are likely to not have a large amount of edges, we'll go with the simple O(n^2) solution for safety
-//     // The width is the minimum length span
-//     assert(p.size() > 2); // Ensure the polygon has at least 3 vertices
-//     std::list<Span> spans;
-//     unsigned int i = 0, j = 2;
-//     float_type dDist1, dDist2;
-//     Edge e(p.v[i], p.v[(i + 1) % p.size()]);
-//     while (i < p.size()) // Compare the deltaDistances to get the span in V-E form for every edge
-//     {
-//      dDist1 = deltaDistance(p, i, (j % p.size()));
-//      ++j;
-//      if ((j % p.size()) == i) // We've wrapped around and there are no more vertices to consider
-//      {
-//          int prevIndex = j - 1;
-//          while (prevIndex < 0)
-//              prevIndex += p.size();
-//          spans.push_back(Span(p.v[prevIndex], e)); // Set the previous vertex as the antipodal vertex for this edge
-//          // Consider the next edge
-//          float_type prevSlope = e.slope();
-//          ++i;
-//          e = Edge(p.v[i], p.v[(i + 1) % p.size()]);
-//          while (e.slope() == prevSlope && i < p.size()) // Ignore adjacent edges with equivalent slope as these will yield an equivalent span
-//          {
-//              ++i;
-//              e = Edge(p.v[i], p.v[(i + 1) % p.size()]);
-//          }
-//      }
-//      else
-//      {
-//          dDist2 = deltaDistance(p, i, j % p.size());
-//          if ((dDist1 >= 0 && dDist2 < 0) || (dDist1 <= 0 && dDist2 > 0)) // deltaDistance changed signs
-//          {
-//              // j is the antipodal vertex of edge i, (i + 1)
-//              spans.push_back(Span(p.v[j % p.size()], e)); // Construct the span of edge e with antipodal vertex j
-//              float_type prevSlope = e.slope();
-//              ++i;
-//              e = Edge(p.v[i], p.v[(i + 1) % p.size()]);
-//              while (e.slope() == prevSlope && i < p.size())
-//              {
-//                  ++i;
-//                  e = Edge(p.v[i % p.size()], p.v[(i + 1) % p.size()]);
-//              }
-//          }
-//      }
-//     }
-//     // Get the minimum length span
-//     Span width = spans.front();
-//     spans.pop_front();
-//     while (!spans.empty())
-//     {
-//      if (spans.front().length() < width.length())
-//          width = spans.front();
-//      spans.pop_front();
-//     }
-//     return width;
-// }
+        Key(const Coord &v1, const Coord &v2)
+        {
+            // Add zero so -0.0 and 0.0 hash the same since they compare equal
+            Coord c1(v1.x + 0.0, v1.y + 0.0), c2(v2.x + 0.0, v2.y + 0.0);
+            bool ordered = (c1.x < c2.x) || (c1.x == c2.x && c1.y <= c2.y);
+            a = ordered ? c1 : c2;
+            b = ordered ? c2 : c1;
+        }
+        bool operator==(const Key &op) const
+        { return a == op.a && b == op.b; }
+    };
+    /**
+     * @brief Hash of an edge key.
+     */
+    struct KeyHash
+    {
+        size_t operator()(const Key &k) const
+        {
+            std::hash<float_type> h;
+            size_t seed = h(k.a.x);
+            seed ^= h(k.a.y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= h(k.b.x) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= h(k.b.y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+    /**
+     * @brief The region id and edge index of every polygon edge with a given key.
+     */
+    std::unordered_map<Key, std::vector<std::pair<unsigned int, unsigned int> >, KeyHash> edges;
 
-Span getWidth(const Polygon &p) // Simple O(n^2) implementation
-{
-    std::vector<Span> spans; // List of candidate spans
-    unsigned int minSpan = -1;
-    float_type minLength = -1;
-    for (unsigned int i = 0; i < p.size(); ++i)
+    /**
+     * @brief Add the edges of a region.
+     * @param id id of the region
+     * @param p the region's polygon
+     */
+    void add(unsigned int id, const Polygon &p)
     {
-        Edge e = p.edge(i);
-        Coord maxVert;
-        float_type maxDistance = -1;
-        for (unsigned int j = 2; j < p.size(); ++j)
+        for (unsigned int i = 0; i < p.size(); ++i)
+            edges[Key(p.v[i], p.v[(i + 1) % p.size()])].push_back(std::make_pair(id, i));
+    }
+    /**
+     * @brief Remove the edges of a region.
+     * @param id id of the region
+     * @param p the region's polygon as it was added
+     */
+    void remove(unsigned int id, const Polygon &p)
+    {
+        for (unsigned int i = 0; i < p.size(); ++i)
         {
-            float_type currDistance = distance(p.v[(i + j) % p.size()], e);
-            if (currDistance > maxDistance)
-            {
-                maxDistance = currDistance;
-                maxVert = p.v[(i + j) % p.size()];
-            }
+            std::unordered_map<Key, std::vector<std::pair<unsigned int, unsigned int> >, KeyHash>::iterator it = edges.find(Key(p.v[i], p.v[(i + 1) % p.size()]));
+            if (it == edges.end())
+                continue;
+            std::vector<std::pair<unsigned int, unsigned int> > &owners = it->second;
+            owners.erase(std::remove(owners.begin(), owners.end(), std::make_pair(id, i)), owners.end());
+            if (owners.empty())
+                edges.erase(it);
         }
-        spans.push_back(Span(maxVert, e));
     }
-    // Get the min length span
-    for (unsigned int i = 0; i < spans.size(); ++i)
+    /**
+     * @brief Find the regions that share an edge with a region.
+     * Matches Polygon::adjacent() by reporting, for each neighbor, the first of the region's edges they share.
+     * @param id id of the region
+     * @param p the region's polygon
+     * @param result stores the shared edge index in p and in the neighbor keyed by neighbor id
+     */
+    void neighbors(unsigned int id, const Polygon &p, std::map<unsigned int, std::pair<unsigned int, unsigned int> > &result) const
     {
-        if (spans[i].length() < minLength || minLength == -1 )
+        result.clear();
+        for (unsigned int i = 0; i < p.size(); ++i)
         {
-            minLength = spans[i].length();
-            minSpan = i;
+            std::unordered_map<Key, std::vector<std::pair<unsigned int, unsigned int> >, KeyHash>::const_iterator it = edges.find(Key(p.v[i], p.v[(i + 1) % p.size()]));
+            if (it == edges.end())
+                continue;
+            for (size_t k = 0; k < it->second.size(); ++k)
+                if (it->second[k].first != id)
+                    result.insert(std::make_pair(it->second[k].first, std::make_pair(i, it->second[k].second)));
         }
     }
-    return spans[minSpan];
-}
+};
 
-bool isConcave(const Polygon &p, int i) // Determine if vertex i is concave or not
+/**
+ * @brief Precomputed geometry of the boundary polygon for answering many pathTo queries.
+ * Holds the boundary edges, the inflated concave vertices, and the visibility between every pair of them.
+ * Build this once after the boundary is loaded. Each query then only has to connect its two end points.
+ * Visible lines keep the turn radius from every boundary edge and corner, which is the same as staying
+ * inside the boundary inflated by the radius with its concave corners rounded.
+ * @see pathTo inflate
+ */
+struct BoundaryIndex
 {
-    assert(i >= 0 && (unsigned int)i < p.size());
-    // Let vertex i be B, vertex i - 1 be A, and vertex i + 1 be C
-    // Get the coordinates of vectors BA and BC
-    int prevIndex = i - 1;
-    while (prevIndex < 0)
-        prevIndex += p.size();
-    float_type BAx = p.v[(prevIndex) % p.size()].x - p.v[i].x;
-    float_type BAy = p.v[(prevIndex) % p.size()].y - p.v[i].y;
-    float_type BCx = p.v[(i + 1) % p.size()].x - p.v[i].x;
-    float_type BCy = p.v[(i + 1) % p.size()].y - p.v[i].y;
-    // Use the sign of the Z-coord of the cross product to determine concavity
-    // Since we are visiting the vertices CCW, vertex i is concave if Z-coord > 0
-    return ((BAx * BCy - BAy * BCx) > 0);
-}
+    /**
+     * @brief The boundary polygon.
+     * @see Polygon
+     */
+    Polygon boundary;
+    /**
+     * @brief The edges of the boundary polygon.
+     * @see Edge
+     */
+    std::vector<Edge> edges;
+    /**
+     * @brief The distance kept from the boundary edges.
+     */
+    float_type radius;
+    /**
+     * @brief Visibility graph over the concave vertices of the boundary inflated inward.
+     * Edges join vertices that can see each other and are weighted by their distance.
+     * @see inflate
+     */
+    Graph<Coord, float_type, SparseStorage> graph;
 
-void split(const Polygon &p, int v1, int v2, Polygon &p1, Polygon &p2) // Splits p by edge v1, v2 and stores result in p1 and p2
-{
-    assert((v1 >= 0 && v2 >= 0) && ((unsigned int)v1 < p.size()) && ((unsigned int)v2 < p.size())); // Make sure indices are in bounds
-    if (abs(v1 - v2) < 2) // Invalid edge
-        return;
-    if (v1 > v2) // Ensure that v1 is the lower index
+    /**
+     * @brief Build the index for a boundary polygon.
+     * @param b the boundary polygon
+     * @param radius the distance inflated vertices are kept from the boundary
+     */
+    BoundaryIndex(const Polygon &b, float_type r = RADIUS): radius(r)
     {
-        unsigned int temp = v1;
-        v1 = v2;
-        v2 = temp;
+        PROFILE_SCOPE(PHASE_BOUNDARY);
+        boundary = b;
+        for (unsigned int i = 0; i < boundary.size(); ++i)
+            edges.push_back(boundary.edge(i));
+        std::vector<Coord> verts;
+        inflate(boundary, radius, verts);
+        std::vector<unsigned int> sources, targets; // Both directions of every visible pair
+        std::vector<float_type> weights;
+        for (unsigned int i = 0; i < verts.size(); ++i)
+            for (unsigned int j = i + 1; j < verts.size(); ++j)
+                if (visible(verts[i], verts[j]))
+                {
+                    float_type d = distance(verts[i], verts[j]);
+                    sources.push_back(i);
+                    targets.push_back(j);
+                    weights.push_back(d);
+                    sources.push_back(j);
+                    targets.push_back(i);
+                    weights.push_back(d);
+                }
+        SparseStorage<float_type> storage(verts.size(), sources, targets, weights);
+        graph = Graph<Coord, float_type, SparseStorage>(std::move(verts), std::move(storage));
     }
-    // p1 will store the polygon formed from v1 to v2, p2 will store the one formed from v2 to v1
-    p1.v.clear(); p2.v.clear(); // Re-initialize the vertex lists for p1 and p2
-    for (int i = v1; i <= v2; ++i) // Fill p1 with the vertices from v1 to v2
-        p1.addVert(p.v[i]);
-    for (int i = v2; (i % p.v.size()) != (v1 + 1); ++i) // Fill p2 with the vertices from v2 to v1
-        p2.addVert(p.v[i % p.v.size()]);
-}
-
-void decompose(const Polygon &p, std::list<Polygon> &l) // Convex polygon decomposition algorithm
-// Decomposes concave polygon p by adding a new edge between a concave vertex and convex vertex so as to produce the minimum width sum
-{
-    // Uncomment std::cout statements for debugging
-    assert(p.size() > 2);
-    bool acceptConvex = false;
-    std::vector<unsigned int> concaveVerts;
-    Polygon p1, p2; // The resulting polygons from splitting p
-    unsigned int v1 = 0, v2 = 0; // The vertices the polygon will be split at
-    float_type minWidthSum = -1;
-    for (unsigned int i = 0; i < p.size(); ++i) // Get the concave vertex indices of the polygon
-        if (isConcave(p, i))
-            concaveVerts.push_back(i);
-    if (concaveVerts.size() == 0) // If the polygon is convex, return it
+    /**
+     * @brief Determine if the straight line between two points stays inside the boundary and keeps the radius from it.
+     * An end point closer than the radius to an edge only has to keep its own distance from that edge.
+     * @param point1 the first point
+     * @param point2 the second point
+     * @return true if the line does not cross the boundary or come closer to it than allowed, else false
+     * @see Coord
+     */
+    bool visible(const Coord &point1, const Coord &point2) const
     {
-        l.push_back(p);
-        return;
+        Edge line(point1, point2);
+        Coord inter;
+        for (unsigned int i = 0; i < edges.size(); ++i)
+            if (intersection(line, edges[i], inter))
+                return false;
+        if (!inside((point1 + point2) * 0.5, boundary))
+            return false;
+        for (unsigned int i = 0; i < edges.size(); ++i)
+        {
+            float_type clearance = std::min(radius, std::min(segmentDistance(point1, edges[i]), segmentDistance(point2, edges[i])));
+            if (segmentDistance(line, edges[i]) < clearance * (1 - 1e-9)) // Lines along the inflated boundary are exactly radius away
+                return false;
+        }
+        return true;
     }
-    // We'll use the concave vertex to other concave vertex style of splitting the polygon for now
-    // Should this not work out, we can try a different style (eg. concave vertex to edge)
-    // DEBUG PRINTS
+};
+
+/**
+ * @brief Pull based stream over the waypoints of a planned search path.
+ * Holds the sweep legs of each subregion in traversal order and reads them out one waypoint at a time
+ * in the order given by each subregion's start state. Transitions between subregions are routed with
+ * pathTo() only when the stream reaches them.
+ * @see searchPathStream naivePathStream State
+ */
+struct PathStream
+{
+    /**
+     * @brief The sweep legs of each subregion in traversal order.
+     * @see Edge
+     */
+    std::vector<std::vector<Edge> > legs;
+    /**
+     * @brief The start state of each subregion.
+     * @see State
+     */
+    std::vector<State> states;
+    /**
+     * @brief The positions of the subregions that share an edge with each subregion, or empty if unknown.
+     */
+    std::vector<std::vector<unsigned int> > adjacency;
+    /**
+     * @brief If not null, transitions into each subregion are routed to stay inside this boundary.
+     * @see BoundaryIndex
+     */
+    const BoundaryIndex *boundary;
+    /**
+     * @brief Waypoints of the transition currently being read.
+     */
+    std::vector<Coord> transit;
+    /**
+     * @brief Number of waypoints of the transition already read.
+     */
+    size_t transitRead;
+    /**
+     * @brief The last waypoint read, or the start point if nothing has been read yet.
+     */
+    Coord last;
+    /**
+     * @brief Whether last holds a point to route transitions from.
+     */
+    bool hasLast;
+    /**
+     * @brief Index of the next subregion to enter.
+     */
+    unsigned int region;
+    /**
+     * @brief Number of legs of the current subregion already read.
+     */
+    size_t leg;
+    /**
+     * @brief Whether the first waypoint of the current leg has been read.
+     */
+    bool midLeg;
+    /**
+     * @brief Whether reading stopped at a transition that could not be routed inside the boundary.
+     */
+    bool failed;
+
+    /**
+     * @brief Construct an empty stream.
+     * @param b if not null, transitions into each subregion are routed to stay inside this boundary
+     */
+    PathStream(const BoundaryIndex *b = NULL): boundary(b), transitRead(0), hasLast(false), region(0), leg(0), midLeg(false), failed(false)
+    {}
+    /**
+     * @brief Append a subregion to the end of the path.
+     * @param path the sweep legs of the subregion
+     * @param state the start state of the subregion
+     */
+    void addSubregion(std::vector<Edge> &&path, State state)
+    {
+        legs.push_back(std::move(path));
+        states.push_back(state);
+    }
+    /**
+     * @brief Count the waypoints of every sweep leg, leaving out transitions.
+     * @return the number of sweep waypoints
+     */
+    size_t sweepSize() const
+    {
+        size_t n = 0;
+        for (unsigned int i = 0; i < legs.size(); ++i)
+            n += 2 * legs[i].size();
+        return n;
+    }
+    /**
+     * @brief Route the first waypoint from a starting point.
+     * Only has an effect if the stream has a boundary. The start point itself is not yielded.
+     * @param c the starting point
+     */
+    void setStart(const Coord &c)
+    {
+        last = c;
+        hasLast = true;
+    }
+    /**
+     * @brief Read the next waypoint.
+     * @param c stores the waypoint
+     * @return true if a waypoint was read, false once the path is exhausted or a transition could not be routed.
+     * Check failed to tell the two apart
+     */
+    bool next(Coord &c)
+    {
+        if (failed)
+            return false;
+        while (true)
+        {
+            if (transitRead < transit.size())
+            {
+                c = transit[transitRead++];
+                break;
+            }
+            if (region > 0 && leg < legs[region - 1].size())
+            {
+                // States starting at the end edge read the legs backwards and states on v2 read each leg backwards
+                const std::vector<Edge> &path = legs[region - 1];
+                State s = states[region - 1];
+                const Edge &e = (s == END_V1 || s == END_V2) ? path[path.size() - 1 - leg] : path[leg];
+                bool flip = (s == START_V2 || s == END_V2);
+                c = (flip != midLeg) ? e.v2 : e.v1;
+                if (midLeg)
+                    ++leg;
+                midLeg = !midLeg;
+                break;
+            }
+            if (region == legs.size())
+                return false;
+            // Enter the next subregion
+            const std::vector<Edge> &path = legs[region];
+            State s = states[region];
+            ++region;
+            leg = 0;
+            midLeg = false;
+            if (!path.empty() && boundary != NULL && hasLast) // Route the transition from the previous subregion
+            {
+                const Edge &first = (s == END_V1 || s == END_V2) ? path.back() : path.front();
+                transitRead = 0;
+                if (!pathTo(last, (s == START_V2 || s == END_V2) ? first.v2 : first.v1, *boundary, transit))
+                {
+                    failed = true; // Never fly the straight line that was just ruled out
+                    return false;
+                }
+            }
+        }
+        last = c;
+        hasLast = true;
+        return true;
+    }
+};
+
+/**
+ * @brief The results of the previous plan kept so an edited search polygon can be replanned incrementally.
+ * Every polygon decompose() split and every subregion traverse() swept is stored by its exact vertices.
+ * When the search polygon is edited, pieces whose vertices are unchanged get their decomposition and
+ * sweep legs from the memo, so only the pieces containing an edited vertex are split and swept again.
+ * The traversal order is only solved again if the merged subregions no longer connect the same way.
+ * Otherwise the previous order is kept and only the start states are recomputed, which can leave the
+ * plan slightly longer than one planned from scratch. Entries not used by the latest plan are dropped
+ * so the memo does not grow across edits. Each decomposition records the halves it was split into, so
+ * reusing a piece also keeps the entries of every piece below it for the edits that follow.
+ * @see searchPathStream decompose
+ */
+struct PlanMemo
+{
+    /**
+     * @brief Hash of a polygon's vertex list.
+     */
+    struct VertsHash
+    {
+        size_t operator()(const std::vector<Coord> &v) const
+        {
+            std::hash<float_type> h;
+            size_t seed = v.size();
+            for (size_t i = 0; i < v.size(); ++i)
+            {
+                seed ^= h(v[i].x) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+                seed ^= h(v[i].y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+    /**
+     * @brief How a polygon was decomposed.
+     */
+    struct Decomposition
+    {
+        /**
+         * @brief The convex subregions.
+         */
+        std::list<Polygon> pieces;
+        /**
+         * @brief Vertices of the two halves the polygon was split into. Empty if it was already convex.
+         */
+        std::vector<std::vector<Coord> > halves;
+    };
+    typedef std::unordered_map<std::vector<Coord>, Decomposition, VertsHash> DecompositionMap;
+    typedef std::unordered_map<std::vector<Coord>, std::vector<Edge>, VertsHash> TraversalMap;
+
+    /**
+     * @brief Guards the decomposition maps since the halves of a polygon are decomposed in parallel.
+     */
+    std::mutex mutex;
+    /**
+     * @brief Decompositions used by the plan in progress and by the previous plan.
+     */
+    DecompositionMap decompositions, oldDecompositions;
+    /**
+     * @brief Sweep legs used by the plan in progress and by the previous plan.
+     */
+    TraversalMap traversals, oldTraversals;
+    /**
+     * @brief Vertices of the merged subregions of the previous plan in list order.
+     */
+    std::vector<std::vector<Coord> > subregions;
+    /**
+     * @brief Adjacency of the merged subregions of the previous plan.
+     */
+    std::vector<std::vector<unsigned int> > adjacency;
+    /**
+     * @brief Traversal order of the previous plan.
+     */
+    std::list<unsigned int> order;
+    /**
+     * @brief Start state of each merged subregion of the previous plan in list order.
+     */
+    std::vector<State> states;
+    /**
+     * @brief The parameters the memo was filled with. Changing them clears the memo.
+     */
+    float_type offset, radius, correction;
+    /**
+     * @brief Number of decompositions and traversals reused by the latest plan.
+     */
+    unsigned int reused;
+    /**
+     * @brief Whether the latest plan kept the previous traversal order.
+     */
+    bool reusedOrder;
+
+    PlanMemo(): offset(-1), radius(-1), correction(-1), reused(0), reusedOrder(false)
+    {}
+    /**
+     * @brief Start a new plan. Entries used by the previous plan stay available to this one.
+     * @param config the planning parameters of the new plan
+     */
+    void begin(const PlannerConfig &config)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (config.offset != offset || config.radius != radius || config.correction != correction)
+        {
+            decompositions.clear();
+            traversals.clear();
+            subregions.clear();
+            order.clear();
+            offset = config.offset;
+            radius = config.radius;
+            correction = config.correction;
+        }
+        oldDecompositions.swap(decompositions);
+        decompositions.clear();
+        oldTraversals.swap(traversals);
+        traversals.clear();
+        reused = 0;
+        reusedOrder = false;
+    }
+    /**
+     * @brief Look up the decomposition of a polygon and keep it for the next plan.
+     * @param p the polygon
+     * @param l the subregions are appended to l if found
+     * @return true if the polygon was decomposed before, else false
+     */
+    bool findDecomposition(const Polygon &p, std::list<Polygon> &l)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!keepDecomposition(p.v))
+            return false;
+        const std::list<Polygon> &pieces = decompositions.find(p.v)->second.pieces;
+        l.insert(l.end(), pieces.begin(), pieces.end());
+        ++reused;
+        return true;
+    }
+    /**
+     * @brief Keep the previous plan's decomposition of a polygon and of every half below it for the next plan.
+     * The mutex must be held.
+     * @param v vertices of the polygon
+     * @return true if the polygon was decomposed by this plan or the previous one, else false
+     */
+    bool keepDecomposition(const std::vector<Coord> &v)
+    {
+        if (decompositions.count(v) > 0)
+            return true;
+        DecompositionMap::iterator old = oldDecompositions.find(v);
+        if (old == oldDecompositions.end())
+            return false;
+        const Decomposition &d = decompositions.insert(std::make_pair(v, old->second)).first->second;
+        for (size_t i = 0; i < d.halves.size(); ++i)
+            keepDecomposition(d.halves[i]);
+        return true;
+    }
+    /**
+     * @brief Store the decomposition of a polygon.
+     * @param p the polygon
+     * @param l its subregions
+     * @param halves vertices of the two halves p was split into. Empty if p is convex
+     */
+    void storeDecomposition(const Polygon &p, const std::list<Polygon> &l, const std::vector<std::vector<Coord> > &halves)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Decomposition &d = decompositions[p.v];
+        d.pieces = l;
+        d.halves = halves;
+    }
+    /**
+     * @brief Sweep a convex subregion, reusing its sweep legs if it was swept before.
+     * @param p the subregion
+     * @param waypoints stores the sweep legs
+     * @param config supplies the sweep spacing and correction
+     * @see traverse
+     */
+    void traverse(const Polygon &p, std::vector<Edge> &waypoints, const PlannerConfig &config)
+    {
+        TraversalMap::iterator it = traversals.find(p.v);
+        if (it == traversals.end())
+        {
+            TraversalMap::iterator old = oldTraversals.find(p.v);
+            if (old == oldTraversals.end())
+            {
+                ::traverse(p, waypoints, config);
+                traversals[p.v] = waypoints;
+                return;
+            }
+            it = traversals.insert(std::make_pair(p.v, old->second)).first;
+        }
+        waypoints = it->second;
+        ++reused;
+    }
+};
+
+//============================================================
+// Functions
+//============================================================
+float_type distance(const Coord &v1, const Coord &v2) // Find the distance between two vertices
+{ return sqrt(pow((v2.y - v1.y), 2) + pow(v2.x - v1.x, 2)); }
+
+float_type distance(const Coord &v, const Edge &e) // Find the distance between a vertex and an edge
+{
+    if (e.isVertical()) // Special case for distance from a perfectly vertical edge
+        return std::abs(e.v1.x - v.x);
+    float_type numer = std::abs((e.a * v.x) + (e.b * v.y) + e.c);
+    float_type denom = sqrt(e.a * e.a + e.b * e.b);
+    return numer / denom;
+}
+
+float_type segmentDistance(const Coord &v, const Edge &e) // Distance to the closest point of segment e
+{
+    Coord d = e.v2 - e.v1;
+    float_type length2 = d * d;
+    if (length2 == 0)
+        return distance(v, e.v1);
+    float_type t = ((v - e.v1) * d) / length2; // Projection of v onto the segment clamped to its end points
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    return distance(v, e.v1 + d * t);
+}
+
+float_type segmentDistance(const Edge &e1, const Edge &e2) // Distance between the closest points of two segments
+{
+    Coord inter;
+    if (intersection(e1, e2, inter))
+        return 0;
+    // Without an intersection the closest points include an end point of one of the segments
+    return std::min(std::min(segmentDistance(e1.v1, e2), segmentDistance(e1.v2, e2)),
+                    std::min(segmentDistance(e2.v1, e1), segmentDistance(e2.v2, e1)));
+}
+
+void convexHull(const std::vector<Coord> &v, std::vector<Coord> &hull) // Andrew's monotone chain
+{
+    std::vector<Coord> sorted(v);
+    std::sort(sorted.begin(), sorted.end(), [](const Coord &c1, const Coord &c2)
+              { return c1.x < c2.x || (c1.x == c2.x && c1.y < c2.y); });
+    hull.assign(2 * sorted.size(), Coord());
+    unsigned int k = 0;
+    for (unsigned int i = 0; i < sorted.size(); ++i) // Lower hull
+    {
+        while (k >= 2 && cross(hull[k - 1] - hull[k - 2], sorted[i] - hull[k - 2]) <= 0)
+            --k;
+        hull[k++] = sorted[i];
+    }
+    for (int i = (int)sorted.size() - 2, lower = k + 1; i >= 0; --i) // Upper hull
+    {
+        while ((int)k >= lower && cross(hull[k - 1] - hull[k - 2], sorted[i] - hull[k - 2]) <= 0)
+            --k;
+        hull[k++] = sorted[i];
+    }
+    hull.resize(k > 1 ? k - 1 : k); // The last point is the same as the first
+}
+
+Span getWidth(const Polygon &p) // Cached width of a polygon
+{
+    if (!p.widthCached)
+    {
+        p.width = computeWidth(p);
+        p.widthCached = true;
+    }
+    return p.width;
+}
+
+Span getWidth(const PolygonView &p) // Width of a polygon view
+{ return computeWidth(p); }
+
+template <typename P>
+Span computeWidth(const P &p) // Rotating calipers over the convex hull
+{
+    assert(p.size() > 2);
+    // The farthest vertex from the line through an edge is always a vertex of the convex hull, and it is the extreme
+    // hull vertex in the direction of one of the edge's normals. As the normal rotates CCW the extreme vertex does too,
+    // so a single pointer walking the hull answers the normals in angular order.
+    bool convex = true;
+    for (unsigned int i = 0; i < p.size() && convex; ++i)
+        if (isConcave(p, i))
+            convex = false;
+    std::vector<Coord> hull;
+    std::vector<Coord> normals; // Query directions in CCW angular order
+    std::vector<unsigned int> edgeIndex; // The edge each query direction belongs to
+    if (convex)
+    {
+        // The polygon is its own hull and its edge normals are already in angular order. Only the inward normal matters
+        for (unsigned int i = 0; i < p.size(); ++i)
+        {
+            Coord prev = p.vert((i + p.size() - 1) % p.size());
+            Coord next = p.vert((i + 1) % p.size());
+            if (cross(p.vert(i) - prev, next - p.vert(i)) != 0) // Skip collinear vertices
+                hull.push_back(p.vert(i));
+            Coord dir = next - p.vert(i);
+            normals.push_back(Coord(-dir.y, dir.x));
+            edgeIndex.push_back(i);
+        }
+    }
+    else
+    {
+        // Edges can have vertices on both sides so query both normals of each edge after sorting them by angle
+        std::vector<Coord> verts(p.size());
+        for (unsigned int i = 0; i < p.size(); ++i)
+            verts[i] = p.vert(i);
+        convexHull(verts, hull);
+        std::vector<std::pair<float_type, unsigned int> > angles;
+        for (unsigned int i = 0; i < p.size(); ++i)
+        {
+            Coord dir = p.vert((i + 1) % p.size()) - p.vert(i);
+            angles.push_back(std::make_pair(atan2(dir.x, -dir.y), 2 * i));
+            angles.push_back(std::make_pair(atan2(-dir.x, dir.y), 2 * i + 1));
+        }
+        std::sort(angles.begin(), angles.end());
+        for (unsigned int k = 0; k < angles.size(); ++k)
+        {
+            unsigned int i = angles[k].second / 2;
+            Coord dir = p.vert((i + 1) % p.size()) - p.vert(i);
+            normals.push_back((angles[k].second % 2) ? Coord(-dir.y, dir.x) : Coord(dir.y, -dir.x));
+            edgeIndex.push_back(i);
+        }
+    }
+    if (hull.size() < 3) // Degenerate polygon with every vertex on a line
+        return getWidthNaive(p);
+    std::vector<float_type> maxDistance(p.size(), -1);
+    std::vector<Coord> maxVert(p.size());
+    unsigned int j = 0; // Index of the extreme hull vertex for the current query
+    for (unsigned int k = 1; k < hull.size(); ++k) // Find the extreme vertex for the first query directly
+        if (normals[0] * hull[k] > normals[0] * hull[j])
+            j = k;
+    for (unsigned int k = 0; k < normals.size(); ++k)
+    {
+        for (unsigned int steps = 0; steps < hull.size() && normals[k] * hull[(j + 1) % hull.size()] > normals[k] * hull[j]; ++steps)
+            j = (j + 1) % hull.size();
+        unsigned int i = edgeIndex[k];
+        float_type currDistance = distance(hull[j], p.edge(i));
+        if (currDistance > maxDistance[i])
+        {
+            maxDistance[i] = currDistance;
+            maxVert[i] = hull[j];
+        }
+    }
+    // Get the min length span
+    unsigned int minSpan = 0;
+    for (unsigned int i = 1; i < p.size(); ++i)
+        if (maxDistance[i] < maxDistance[minSpan])
+            minSpan = i;
+    return Span(maxVert[minSpan], p.edge(minSpan));
+}
+
+template <typename P>
+Span getWidthNaive(const P &p) // Simple O(n^2) implementation
+{
+    std::vector<Span> spans; // List of candidate spans
+    unsigned int minSpan = -1;
+    float_type minLength = -1;
+    for (unsigned int i = 0; i < p.size(); ++i)
+    {
+        Edge e = p.edge(i);
+        Coord maxVert;
+        float_type maxDistance = -1;
+        for (unsigned int j = 2; j < p.size(); ++j)
+        {
+            float_type currDistance = distance(p.vert((i + j) % p.size()), e);
+            if (currDistance > maxDistance)
+            {
+                maxDistance = currDistance;
+                maxVert = p.vert((i + j) % p.size());
+            }
+        }
+        spans.push_back(Span(maxVert, e));
+    }
+    // Get the min length span
+    for (unsigned int i = 0; i < spans.size(); ++i)
+    {
+        if (spans[i].length() < minLength || minLength == -1 )
+        {
+            minLength = spans[i].length();
+            minSpan = i;
+        }
+    }
+    return spans[minSpan];
+}
+
+template <typename P>
+bool isConcave(const P &p, int i) // Determine if vertex i is concave or not
+{
+    assert(i >= 0 && (unsigned int)i < p.size());
+    // Let vertex i be B, vertex i - 1 be A, and vertex i + 1 be C
+    // Get the coordinates of vectors BA and BC
+    int prevIndex = i - 1;
+    while (prevIndex < 0)
+        prevIndex += p.size();
+    float_type BAx = p.vert((prevIndex) % p.size()).x - p.vert(i).x;
+    float_type BAy = p.vert((prevIndex) % p.size()).y - p.vert(i).y;
+    float_type BCx = p.vert((i + 1) % p.size()).x - p.vert(i).x;
+    float_type BCy = p.vert((i + 1) % p.size()).y - p.vert(i).y;
+    // Use the sign of the Z-coord of the cross product to determine concavity
+    // Since we are visiting the vertices CCW, vertex i is concave if Z-coord > 0
+    return ((BAx * BCy - BAy * BCx) > 0);
+}
+
+void split(const Polygon &p, int v1, int v2, Polygon &p1, Polygon &p2) // Splits p by edge v1, v2 and stores result in p1 and p2
+{
+    PolygonView view1, view2;
+    splitView(p, v1, v2, view1, view2);
+    if (view1.size() == 0) // Invalid edge
+        return;
+    view1.copyTo(p1);
+    view2.copyTo(p2);
+}
+
+void splitView(const Polygon &p, int v1, int v2, PolygonView &p1, PolygonView &p2) // Splits p by edge v1, v2 and stores the views in p1 and p2
+{
+    assert((v1 >= 0 && v2 >= 0) && ((unsigned int)v1 < p.size()) && ((unsigned int)v2 < p.size())); // Make sure indices are in bounds
+    if (abs(v1 - v2) < 2) // Invalid edge
+        return;
+    if (v1 > v2) // Ensure that v1 is the lower index
+    {
+        unsigned int temp = v1;
+        v1 = v2;
+        v2 = temp;
+    }
+    // p1 views the polygon formed from v1 to v2, p2 views the one formed from v2 around to v1
+    p1 = PolygonView(p, v1, v2 + 1);
+    p2 = PolygonView(p, v2, p.size(), 0, v1 + 1);
+}
+
+bool scoreSplit(const Polygon &p, unsigned int c, unsigned int j, Span &width1, Span &width2, bool checkAngle) // Check split c, j against the interior angle at c and get the resulting widths
+{
+    int prevIndex = c - 1;
+    while (prevIndex < 0)
+        prevIndex += p.size();
+    // Check against the interior angle to ensure a valid split
+    bool valid;
+    Edge splitEdge(p.v[c], p.v[j]);
+    float_type splitTheta = splitEdge.theta();
+    float_type theta1 = p.edge(c).theta();
+    float_type theta2 = p.edge(prevIndex % p.size()).theta();
+    if (theta2 - PI < EPSILON)
+        theta2 = 0;
+    else
+        theta2 += PI;
+    if (theta1 > theta2)
+    {
+        valid = true;
+        if (splitTheta > theta2 && splitTheta < theta1)
+            valid = false;
+    }
+    else
+    {
+        valid = false;
+        if (splitTheta >= theta1 && splitTheta <= theta2)
+            valid = true;
+    }
+    if (!checkAngle)
+        valid = true;
+    for (unsigned int i = 0; valid && i < p.size(); ++i) // The split must not leave the polygon through another edge
+    {
+        unsigned int next = (i + 1) % p.size();
+        if (i == c || next == c || i == j || next == j)
+            continue;
+        Coord inter;
+        if (intersection(splitEdge, p.edge(i), inter))
+            valid = false;
+    }
+    if (valid && !inside((p.v[c] + p.v[j]) * 0.5, p)) // Without a crossing the split is either wholly inside or wholly outside
+        valid = false;
+    if (valid)
+    {
+        //std::cout << "Splitting at " << p.v[c].str() << ", " << p.v[j].str() << "\n";
+        PolygonView view1, view2;
+        splitView(p, c, j, view1, view2); // Score the split without copying vertices
+        width1 = getWidth(view1);
+        width2 = getWidth(view2);
+    }
+    return valid;
+}
+
+void decompose(const Polygon &p, std::list<Polygon> &l, PlanMemo *memo) // Convex polygon decomposition algorithm
+{
+    if (memo == NULL)
+    {
+        decomposeSplit(p, l, NULL);
+        return;
+    }
+    if (memo->findDecomposition(p, l)) // This piece was not touched by the edit
+        return;
+    std::list<Polygon> pieces;
+    std::vector<std::vector<Coord> > halves;
+    decomposeSplit(p, pieces, memo, &halves);
+    memo->storeDecomposition(p, pieces, halves);
+    l.splice(l.end(), pieces);
+}
+
+void decomposeSplit(const Polygon &p, std::list<Polygon> &l, PlanMemo *memo, std::vector<std::vector<Coord> > *halves)
+// Decomposes concave polygon p by adding a new edge between a concave vertex and convex vertex so as to produce the minimum width sum
+{
+    // Uncomment std::cout statements for debugging
+    assert(p.size() > 2);
+    bool acceptConvex = false;
+    bool checkAngle = true; // The interior angle test rejects some splits that stay inside the polygon
+    std::vector<unsigned int> concaveVerts;
+    Polygon p1, p2; // The resulting polygons from splitting p
+    unsigned int v1 = 0, v2 = 0; // The vertices the polygon will be split at
+    Span width1, width2; // The widths of the polygons produced by the best split
+    float_type minWidthSum = -1;
+    for (unsigned int i = 0; i < p.size(); ++i) // Get the concave vertex indices of the polygon
+        if (isConcave(p, i))
+            concaveVerts.push_back(i);
+    TRACE_SPAN("decompose", "vertices", p.size(), "concave", concaveVerts.size());
+    if (concaveVerts.size() == 0) // If the polygon is convex, return it
+    {
+        l.push_back(p);
+        return;
+    }
+    // We'll use the concave vertex to other concave vertex style of splitting the polygon for now
+    // Should this not work out, we can try a different style (eg. concave vertex to edge)
+    // DEBUG PRINTS
     //---
     // std::cout << "ncc = " << concaveVerts.size() << "\n";
     // std::cout << "Concave verts...\n";
@@ -741,8 +1776,9 @@ void decompose(const Polygon &p, std::list<Polygon> &l) // Convex polygon decomp
         acceptConvex = true;
     while (minWidthSum == -1)
     {
+        std::vector<std::pair<unsigned int, unsigned int> > candidates; // Splits to score in the order they are compared
         for (unsigned int i = 0; i < concaveVerts.size(); ++i)
-        { // Find the split that produces the minimum width sum
+        {
             for (unsigned int j = 0; j < p.size(); ++j)
             {
                 bool adjacent = false;
@@ -754,53 +1790,71 @@ void decompose(const Polygon &p, std::list<Polygon> &l) // Convex polygon decomp
                 if (prevIndex == (int)j)
                     adjacent = true;
                 if ((concaveVerts[i] != j) && !adjacent && (isConcave(p, j) || acceptConvex)) // Ignore vertices that would produce an invalid split
-                {
-                    // Check against the interior angle to ensure a valid split
-                    bool valid;
-                    Edge splitEdge(p.v[concaveVerts[i]], p.v[j]);
-                    float_type splitTheta = splitEdge.theta();
-                    float_type theta1 = p.edge(concaveVerts[i]).theta();
-                    float_type theta2 = p.edge(prevIndex % p.size()).theta();
-                    if (theta2 - PI < EPSILON)
-                        theta2 = 0;
-                    else
-                        theta2 += PI;
-                    if (theta1 > theta2)
-                    {
-                        valid = true;
-                        if (splitTheta > theta2 && splitTheta < theta1)
-                            valid = false;
-                    }
-                    else
-                    {
-                        valid = false;
-                        if (splitTheta >= theta1 && splitTheta <= theta2)
-                            valid = true;
-                    }
-                    if (valid)
-                    {
-                        //std::cout << "Splitting at " << p.v[concaveVerts[i]].str() << ", " << p.v[j].str() << "\n";
-                        split(p, concaveVerts[i], j, p1, p2);
-                        //std::cout << "P1...\n" << p1.str() << "\n";
-                        //std::cout << "P2...\n" << p2.str() << "\n";
-                        float_type widthSum = getWidth(p1) + getWidth(p2);
-                        if (widthSum < minWidthSum || minWidthSum < 0)
-                        {
-                            minWidthSum = widthSum;
-                            v1 = concaveVerts[i];
-                            v2 = j;
-                        }
-                    }
-                }
+                    candidates.push_back(std::make_pair(concaveVerts[i], j));
+            }
+        }
+        // Each candidate is scored independently so only the reduction below has to stay in order
+        PROFILE_COUNT(COUNT_SPLITS, candidates.size());
+        std::vector<char> valid(candidates.size());
+        std::vector<Span> spans1(candidates.size()), spans2(candidates.size());
+        std::function<void(unsigned int)> score = [&](unsigned int k)
+            { valid[k] = scoreSplit(p, candidates[k].first, candidates[k].second, spans1[k], spans2[k], checkAngle); };
+        if (candidates.size() >= PARALLEL_MIN_CANDIDATES)
+            threadPool().parallelFor(candidates.size(), score);
+        else
+            for (unsigned int k = 0; k < candidates.size(); ++k)
+                score(k);
+        for (unsigned int k = 0; k < candidates.size(); ++k) // Find the split that produces the minimum width sum
+        {
+            if (!valid[k])
+                continue;
+            float_type widthSum = spans1[k] + spans2[k];
+            if (widthSum < minWidthSum || minWidthSum < 0)
+            {
+                minWidthSum = widthSum;
+                v1 = candidates[k].first;
+                v2 = candidates[k].second;
+                width1 = spans1[k];
+                width2 = spans2[k];
             }
         }
+        if (minWidthSum == -1 && !checkAngle) // Every simple polygon has a split from a concave vertex, so p crosses itself
+        {
+            std::cout << "Warning: Could not decompose a self-intersecting subregion with " << p.size()
+                      << " vertices. Its sweep may leave the search area\n";
+            l.push_back(p);
+            return;
+        }
+        if (minWidthSum == -1 && acceptConvex) // Fall back to any split that stays inside the polygon
+            checkAngle = false;
         if (minWidthSum == -1) // If we can't split concave to concave, try to split concave to convex
             acceptConvex = true;
     }
     // std::cout << "Splitting at " << p.v[v1].str() << " " << p.v[v2].str() << "\n\n";
-    split(p, v1, v2, p1, p2); // Split polygon p to produce the minimum sum width
-    decompose(p1, l); // Decompose those polygons in turn
-    decompose(p2, l);
+    split(p, v1, v2, p1, p2); // Only materialize the vertices of the split that produces the minimum sum width
+    p1.width = width1; // Keep the widths already computed for the winning split
+    p2.width = width2;
+    p1.widthCached = p2.widthCached = true;
+    if (halves != NULL)
+    {
+        halves->push_back(p1.v);
+        halves->push_back(p2.v);
+    }
+    if (p.size() < PARALLEL_MIN_VERTICES) // Not worth a task so decompose those polygons in turn
+    {
+        decompose(p1, l, memo);
+        decompose(p2, l, memo);
+        return;
+    }
+    // The two halves are independent. Decompose p1 as a task while this thread does p2, then append
+    // p1's subregions before p2's so the order matches the serial recursion
+    std::list<Polygon> l1, l2;
+    TaskGroup group;
+    group.spawn([&p1, &l1, memo]() { decompose(p1, l1, memo); });
+    decompose(p2, l2, memo);
+    group.wait();
+    l.splice(l.end(), l1);
+    l.splice(l.end(), l2);
 }
 
 Polygon merge(const Polygon &p1, const Polygon &p2, unsigned int i, unsigned int j) // Merge two polygons by shared edge at index i of p1 and j of p2 and return the result
@@ -814,36 +1868,70 @@ Polygon merge(const Polygon &p1, const Polygon &p2, unsigned int i, unsigned int
     return result;
 }
 
-void mergeSubregions(std::list<Polygon> &l) // Merge subregions that are adjacent and combine to form a convex polygon
+void mergeSubregions(std::list<Polygon> &l, std::vector<std::vector<unsigned int> > *adjacency) // Merge subregions that are adjacent and combine to form a convex polygon
 {
-    int i, j;
-    std::list<Polygon>::iterator it1 = l.begin();
-    while (it1 != l.end())
+    // Region ids are positions in the original list. Merged regions keep the id of the first region so ids stay in list order
+    std::vector<Polygon> regions;
+    regions.reserve(l.size());
+    for (std::list<Polygon>::iterator it = l.begin(); it != l.end(); ++it)
+        regions.push_back(std::move(*it));
+    std::vector<bool> alive(regions.size(), true);
+    SharedEdgeIndex index;
+    for (unsigned int id = 0; id < regions.size(); ++id)
+        index.add(id, regions[id]);
+    std::map<unsigned int, std::pair<unsigned int, unsigned int> > neighbors;
+    for (unsigned int id1 = 0; id1 < regions.size(); ++id1)
     {
-        std::list<Polygon>::iterator it2 = l.begin();
-        while(it2 != l.end())
+        if (!alive[id1])
+            continue;
+        // Visit the neighbors in list order. After a merge continue past the absorbed region with the merged polygon's neighbors
+        int last = -1;
+        while (true)
         {
-            if (it1 != it2 && it1 != l.end() && it2 != l.end())
+            index.neighbors(id1, regions[id1], neighbors);
+            std::map<unsigned int, std::pair<unsigned int, unsigned int> >::iterator it = neighbors.upper_bound(last);
+            if (last < 0)
+                it = neighbors.begin();
+            if (it == neighbors.end())
+                break;
+            unsigned int id2 = it->first;
+            last = id2;
+            Polygon mergedPoly = merge(regions[id1], regions[id2], it->second.first, it->second.second);
+            unsigned int numConcave = 0;
+            for (unsigned int i = 0; i < mergedPoly.size(); ++i)
+                if (isConcave(mergedPoly, i))
+                    ++numConcave;
+            if (numConcave == 0)
             {
-                if (it1->adjacent(*it2, &i, &j))
-                {
-                    Polygon mergedPoly = merge(*it1, *it2, i, j);
-                    unsigned int numConcave = 0;
-                    for (unsigned int i = 0; i < mergedPoly.size(); ++i)
-                        if (isConcave(mergedPoly, i))
-                            ++numConcave;
-                    if (numConcave == 0)
-                    {
-                        *it1 = mergedPoly;
-                        l.erase(it2);
-                        continue;
-                    }
-                }
+                index.remove(id1, regions[id1]);
+                index.remove(id2, regions[id2]);
+                regions[id1] = std::move(mergedPoly);
+                index.add(id1, regions[id1]);
+                alive[id2] = false;
             }
-            ++it2;
         }
-        ++it1;
     }
+    std::vector<unsigned int> survivors; // Ids of the remaining regions in list order
+    std::vector<unsigned int> position(regions.size()); // Index of each remaining region in the resulting list
+    for (unsigned int id = 0; id < regions.size(); ++id)
+        if (alive[id])
+        {
+            position[id] = survivors.size();
+            survivors.push_back(id);
+        }
+    if (adjacency != NULL)
+    {
+        adjacency->assign(survivors.size(), std::vector<unsigned int>());
+        for (unsigned int k = 0; k < survivors.size(); ++k)
+        {
+            index.neighbors(survivors[k], regions[survivors[k]], neighbors);
+            for (std::map<unsigned int, std::pair<unsigned int, unsigned int> >::iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+                (*adjacency)[k].push_back(position[it->first]);
+        }
+    }
+    l.clear();
+    for (unsigned int k = 0; k < survivors.size(); ++k)
+        l.push_back(std::move(regions[survivors[k]]));
 }
 
 inline float_type cross(const Coord &c1, const Coord &c2) // Cross two coordinates by treating them as positional vectors and return the result
@@ -852,6 +1940,7 @@ inline float_type cross(const Coord &c1, const Coord &c2) // Cross two coordinat
 bool intersection(const Edge &e1, const Edge &e2, Coord &intersect) // Finds the intersection of two line segments and stores the result in intersect.
 // Otherwise, intersect will be NULL. We will treat collinear lines as non-intersecting and return null.
 {
+    PROFILE_COUNT(COUNT_INTERSECTIONS, 1);
     // References this: https://stackoverflow.com/questions/563198/how-do-you-detect-where-two-line-segments-intersect/565282#565282
     // and this: https://www.codeproject.com/tips/862988/find-the-intersection-point-of-two-line-segments
     // We'll use the naming convention used in the reference posts
@@ -875,10 +1964,12 @@ bool intersection(const Edge &e1, const Edge &e2, Coord &intersect) // Finds the
     return false; // No intersection was found
 }
 
-void traverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse convex polygon p and store the waypoints as Edges in a list
+void traverse(const Polygon &p, std::vector<Edge> &waypoints, const PlannerConfig &config) // Traverse convex polygon p and append the waypoints as Edges
 {
     assert(p.size() > 2);
+    TRACE_SPAN("traverse", "vertices", p.size());
     Span width = getWidth(p);
+    waypoints.reserve(waypoints.size() + (size_t)(width.length() / config.offset) + 1); // One sweep leg per offset across the width
     Edge sweepLine = width.e;
     // Extend sweepLine to INF
     if (sweepLine.isVertical())
@@ -907,9 +1998,9 @@ void traverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse convex p
     unsigned int i = 0, j = 0;
     bool found1 = false, found2 = false; // Were intersections 1 and 2 found
     // The sweep line is currently collinear with width.e and extends to INF.
-    // Repeatedly find the intersections of the sweep line + OFFSET and store the intersections as waypoints until we do not find anymore intersections.
-    sweepLine.v1.x += OFFSET * cos(width.theta()); sweepLine.v2.x += OFFSET * cos(width.theta()); // Initially offset the position of the sweep line by OFFSET / 2
-    sweepLine.v1.y += OFFSET * sin(width.theta()); sweepLine.v2.y += OFFSET * sin(width.theta());
+    // Repeatedly find the intersections of the sweep line + offset and store the intersections as waypoints until we do not find anymore intersections.
+    sweepLine.v1.x += config.offset * cos(width.theta()); sweepLine.v2.x += config.offset * cos(width.theta()); // Initially offset the position of the sweep line by one offset
+    sweepLine.v1.y += config.offset * sin(width.theta()); sweepLine.v2.y += config.offset * sin(width.theta());
     do
     {
         i = 0;
@@ -933,24 +2024,24 @@ void traverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse convex p
             // Correct the x-coord
             if (inter2.x > inter1.x) // Waypoints are ordered left to right
             {
-                inter2.x -= abs(CORRECTION * cos(sweepLine.theta()));
-                inter1.x += abs(CORRECTION * cos(sweepLine.theta()));
+                inter2.x -= abs(config.correction * cos(sweepLine.theta()));
+                inter1.x += abs(config.correction * cos(sweepLine.theta()));
             }
             else // Waypoints are ordered right to left
             {
-                inter2.x += abs(CORRECTION * cos(sweepLine.theta()));
-                inter1.x -= abs(CORRECTION * cos(sweepLine.theta()));
+                inter2.x += abs(config.correction * cos(sweepLine.theta()));
+                inter1.x -= abs(config.correction * cos(sweepLine.theta()));
             }
             // Correct the y-coord
             if (inter2.y > inter1.y)
             {
-                inter2.y -= abs(CORRECTION * sin(sweepLine.theta()));
-                inter1.y += abs(CORRECTION * sin(sweepLine.theta()));
+                inter2.y -= abs(config.correction * sin(sweepLine.theta()));
+                inter1.y += abs(config.correction * sin(sweepLine.theta()));
             }
             else
             {
-                inter2.y += abs(CORRECTION * sin(sweepLine.theta()));
-                inter1.y -= abs(CORRECTION * sin(sweepLine.theta()));
+                inter2.y += abs(config.correction * sin(sweepLine.theta()));
+                inter1.y -= abs(config.correction * sin(sweepLine.theta()));
             }
             // Check if the waypoints have crossed each other after correction
             Edge afterCorr(inter1, inter2); // The path after correction
@@ -974,21 +2065,21 @@ void traverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse convex p
                     waypoints.push_back(Edge(inter2, inter1));
             }
         }
-        // OFFSET the sweep line
-        // std::cout << "Offset: " << "(" << OFFSET * cos(width.theta()) << "," << OFFSET * sin(width.theta()) << ")\n";
-        sweepLine.v1.x += OFFSET * cos(width.theta()); sweepLine.v2.x += OFFSET * cos(width.theta());
-        sweepLine.v1.y += OFFSET * sin(width.theta()); sweepLine.v2.y += OFFSET * sin(width.theta());
+        // Offset the sweep line
+        // std::cout << "Offset: " << "(" << config.offset * cos(width.theta()) << "," << config.offset * sin(width.theta()) << ")\n";
+        sweepLine.v1.x += config.offset * cos(width.theta()); sweepLine.v2.x += config.offset * cos(width.theta());
+        sweepLine.v1.y += config.offset * sin(width.theta()); sweepLine.v2.y += config.offset * sin(width.theta());
         ++j;
     } while (found1);
-    // Ensure that there is at least RADIUS worth of vertical clearance for the vertices of the last edge. Else, remove the last edge (Might not be necessary)
+    // Ensure that there is at least a turn radius worth of vertical clearance for the vertices of the last edge. Else, remove the last edge (Might not be necessary)
     if (waypoints.size() > 0)
     {   
-        std::list<Edge>::reverse_iterator lastEdge = waypoints.rbegin();
+        std::vector<Edge>::reverse_iterator lastEdge = waypoints.rbegin();
         // Check v1
         // std::cout << "Width Theta: "<< width.theta() << '\n';
         Coord testCoord((*lastEdge).v1.x, (*lastEdge).v1.y);
-        testCoord.x += RADIUS * cos(width.theta());
-        testCoord.y += RADIUS * sin(width.theta());
+        testCoord.x += config.radius * cos(width.theta());
+        testCoord.y += config.radius * sin(width.theta());
         Edge testEdge((*lastEdge).v1, testCoord);
         for (unsigned int i = 0; i < p.size(); ++i)
         {
@@ -1001,8 +2092,8 @@ void traverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse convex p
         // Check v2
         testCoord.x = (*lastEdge).v2.x;
         testCoord.y = (*lastEdge).v2.y;
-        testCoord.x += RADIUS * cos(width.theta());
-        testCoord.y += RADIUS * sin(width.theta());
+        testCoord.x += config.radius * cos(width.theta());
+        testCoord.y += config.radius * sin(width.theta());
         testEdge = Edge((*lastEdge).v2, testCoord);
         for (unsigned int i = 0; i < p.size(); ++i)
         {
@@ -1015,28 +2106,47 @@ void traverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse convex p
     }
 }
 
-void computeGraph(Graph<Node, float_type> &g) // Fill in the edges and weights of the graph based on the adjacencies and distances between joint points
+void computeGraph(Graph<Node, float_type> &g, const std::vector<std::vector<unsigned int> > *adjacency) // Fill in the edges and weights of the graph based on the adjacencies and distances between joint points
 {
-    // Find the adjacencies
-    for (unsigned int i = 0; i < g.size(); ++i)
+    for (unsigned int i = 0; i < g.size(); ++i) // Initialize the weights
         for (unsigned int j = 0; j < g.size(); ++j)
         {
             if (i == j)
-                g.w[i][j] = 0;
+                g.setWeight(i, j, 0);
             else
-                g.w[i][j] = INF + distance(g.v[i].p->center(), g.v[j].p->center()); // Initialize the weights
-            // Compute the adjacencies
-            if (!(g.e[i][j]) && g.v[i].p->adjacent(*(g.v[j].p))) // adjacent() may need to be optimized if this runs too slow
+                g.setWeight(i, j, INF + distance(g.v[i].p->center(), g.v[j].p->center()));
+        }
+    // Find the adjacencies
+    if (adjacency != NULL)
+    {
+        for (unsigned int i = 0; i < g.size(); ++i)
+            for (unsigned int k = 0; k < (*adjacency)[i].size(); ++k)
+            {
+                g.setEdge(i, (*adjacency)[i][k]);
+                g.setEdge((*adjacency)[i][k], i);
+            }
+    }
+    else
+    {
+        SharedEdgeIndex index;
+        for (unsigned int i = 0; i < g.size(); ++i)
+            index.add(i, *(g.v[i].p));
+        std::map<unsigned int, std::pair<unsigned int, unsigned int> > neighbors;
+        for (unsigned int i = 0; i < g.size(); ++i)
+        {
+            index.neighbors(i, *(g.v[i].p), neighbors);
+            for (std::map<unsigned int, std::pair<unsigned int, unsigned int> >::iterator it = neighbors.begin(); it != neighbors.end(); ++it)
             {
-                g.setEdge(i, j);
-                g.setEdge(j, i);
+                g.setEdge(i, it->first);
+                g.setEdge(it->first, i);
             }
         }
+    }
     // Compute the weights
     for (unsigned int i = 0; i < g.size(); ++i)
         for (unsigned int j = 0; j < g.size(); ++j)
-            if (g.e[i][j])
-                g.w[i][j] = distance(g.v[i].p->center(), g.v[j].p->center()); // Use the distance of centers as a heuristic for the distances between two subregions
+            if (g.hasEdge(i, j))
+                g.setWeight(i, j, distance(g.v[i].p->center(), g.v[j].p->center())); // Use the distance of centers as a heuristic for the distances between two subregions
 }
 
 float_type traversalLength(const Graph<Node, float_type> &g, std::list<unsigned int> &path)
@@ -1050,14 +2160,24 @@ float_type traversalLength(const Graph<Node, float_type> &g, std::list<unsigned
         i = *it;
         ++it;
         j = *it;
-        length += g.w[i][j];
+        length += g.weight(i, j);
     }
     return length;
 }
 
 std::list<unsigned int> minTraversal(Graph<Node, float_type> &g) // Computes the minimum cost traversal for the weighted graph as a list of indeces
 {
-    // We'll just brute force this as this is the fastest approach for graphs with 5 or less nodes and keeps things simple
+    // Brute force is the fastest approach for graphs with 5 or less nodes. Past that the factorial blows up so switch to Held-Karp,
+    // and past HELD_KARP_MAX the 2^n table gets too large so settle for a heuristic
+    if (g.size() <= BRUTE_FORCE_MAX)
+        return bruteForceTraversal(g);
+    if (g.size() <= HELD_KARP_MAX)
+        return heldKarpTraversal(g);
+    return greedyTraversal(g);
+}
+
+std::list<unsigned int> bruteForceTraversal(Graph<Node, float_type> &g) // Try every permutation of the nodes and keep the cheapest
+{
     std::list<unsigned int> bestPath;
     float_type minDistance = -1;
     std::list<unsigned int> verts;
@@ -1065,6 +2185,7 @@ std::list<unsigned int> minTraversal(Graph<Node, float_type> &g) // Computes the
         verts.push_back(i);
     do
     {
+        PROFILE_COUNT(COUNT_PERMUTATIONS, 1);
         float_type currDistance = traversalLength(g, verts);
         if (currDistance < minDistance || minDistance == -1)
         {
@@ -1075,87 +2196,295 @@ std::list<unsigned int> minTraversal(Graph<Node, float_type> &g) // Computes the
     return bestPath;
 }
 
-void computeStates(std::list<unsigned int> &path, Graph<Node, float_type> &g) // Determine the start states of subregions in minimum traversal to optimally link the path
+std::list<unsigned int> heldKarpTraversal(Graph<Node, float_type> &g) // Held-Karp over (visited set, last node) for an open path with a free start
 {
-    // Set the state of first subregion by comparing the distance from joint points to the center of second subregion
-    float_type dist;
-    std::list<unsigned int>::iterator it = path.begin();
-    g.v[*it].startState = START_V1;
-    dist = distance(g.v[*it].path.back().v2, g.v[*(std::next(it))].p->center());
-    if (distance(g.v[*it].path.back().v1, g.v[*(std::next(it))].p->center()) < dist)
+    const unsigned int n = g.size();
+    assert(n > 0 && n < 32);
+    const size_t numSets = (size_t)1 << n;
+    // cost[set * n + last] is the min length of a path visiting exactly the nodes in set and ending at last, or -1 if unreachable
+    std::vector<float_type> cost(numSets * n, -1);
+    std::vector<unsigned char> parent(numSets * n, 0); // The node visited before last on the best path
+    for (unsigned int i = 0; i < n; ++i)
+        cost[((size_t)1 << i) * n + i] = 0;
+    for (size_t set = 1; set < numSets; ++set)
     {
-        dist = distance(g.v[*it].path.back().v1, g.v[*(std::next(it))].p->center());
-        g.v[*it].startState = START_V2;
+        for (unsigned int last = 0; last < n; ++last)
+        {
+            float_type currCost = cost[set * n + last];
+            if (currCost < 0)
+                continue;
+            for (unsigned int next = 0; next < n; ++next)
+            {
+                if (set & ((size_t)1 << next))
+                    continue;
+                size_t nextIndex = (set | ((size_t)1 << next)) * n + next;
+                float_type nextCost = currCost + g.weight(last, next);
+                if (nextCost < cost[nextIndex] || cost[nextIndex] < 0)
+                {
+                    cost[nextIndex] = nextCost;
+                    parent[nextIndex] = last;
+                }
+            }
+        }
     }
-    if (distance(g.v[*it].path.front().v2, g.v[*(std::next(it))].p->center()) < dist)
+    // Find the cheapest end node then walk the parents back to the start
+    size_t set = numSets - 1;
+    unsigned int last = 0;
+    for (unsigned int i = 1; i < n; ++i)
+        if (cost[set * n + i] < cost[set * n + last])
+            last = i;
+    std::list<unsigned int> bestPath;
+    for (unsigned int k = 0; k < n; ++k)
     {
-        dist = distance(g.v[*it].path.front().v2, g.v[*(std::next(it))].p->center());
-        g.v[*it].startState = END_V1;
+        bestPath.push_front(last);
+        unsigned int prev = parent[set * n + last];
+        set &= ~((size_t)1 << last);
+        last = prev;
     }
-    if (distance(g.v[*it].path.front().v1, g.v[*(std::next(it))].p->center()) < dist)
+    return bestPath;
+}
+
+std::list<unsigned int> greedyTraversal(Graph<Node, float_type> &g) // Nearest neighbor from every start node followed by 2-opt on the best result
+{
+    const unsigned int n = g.size();
+    assert(n > 0);
+    std::vector<unsigned int> bestPath;
+    float_type minDistance = -1;
+    for (unsigned int start = 0; start < n; ++start)
     {
-        dist = distance(g.v[*it].path.front().v1, g.v[*(std::next(it))].p->center());
-        g.v[*it].startState = END_V2;
+        std::vector<unsigned int> currPath;
+        std::vector<bool> visited(n, false);
+        float_type currDistance = 0;
+        currPath.push_back(start);
+        visited[start] = true;
+        for (unsigned int k = 1; k < n; ++k)
+        {
+            unsigned int last = currPath.back();
+            int nearest = -1;
+            for (unsigned int i = 0; i < n; ++i)
+                if (!visited[i] && (nearest == -1 || g.weight(last, i) < g.weight(last, nearest)))
+                    nearest = i;
+            currDistance += g.weight(last, nearest);
+            currPath.push_back(nearest);
+            visited[nearest] = true;
+        }
+        if (currDistance < minDistance || minDistance == -1)
+        {
+            minDistance = currDistance;
+            bestPath = currPath;
+        }
     }
-    for (unsigned int i = 0; i < path.size() - 1; ++i)
+    // Reverse sub-paths while doing so shortens the traversal. The whole path is re-measured since weights may be directional
+    bool improved = true;
+    while (improved)
     {
-        Coord joint; // The joint vertex of subregion i that we will measure distances from depends on the start state of i
-        switch (g.v[*it].startState)
+        improved = false;
+        for (unsigned int i = 0; i + 1 < n; ++i)
         {
-        case START_V1:
-            joint = g.v[*it].path.back().v2;
-            break;
-        case START_V2:
-            joint = g.v[*it].path.back().v1;
-            break;
-        case END_V1:
-            joint = g.v[*it].path.front().v2;
-            break;
-        case END_V2:
-            joint = g.v[*it].path.front().v1;
-            break;
-        default:
-            std::cout << "Warning: Unknown start state encountered\n";
+            for (unsigned int j = i + 1; j < n; ++j)
+            {
+                std::vector<unsigned int> candidate = bestPath;
+                std::reverse(candidate.begin() + i, candidate.begin() + j + 1);
+                float_type currDistance = 0;
+                for (unsigned int k = 0; k + 1 < n; ++k)
+                    currDistance += g.weight(candidate[k], candidate[k + 1]);
+                if (currDistance + EPSILON < minDistance)
+                {
+                    minDistance = currDistance;
+                    bestPath.swap(candidate);
+                    improved = true;
+                }
+            }
         }
-        // Find the joint vertex of the next subregion that gives the minimum linear distance
-        ++it;
-        g.v[*it].startState = START_V1;
-        dist = distance(joint, g.v[*it].path.front().v1);
-        if (dist > distance(joint, g.v[*it].path.front().v2))
+    }
+    return std::list<unsigned int>(bestPath.begin(), bestPath.end());
+}
+
+Coord entryPoint(const Node &n, State s) // The first waypoint flown in the subregion for start state s
+{
+    if (n.path.size() == 0) // Nothing to fly so treat the subregion as a single point
+        return n.p->center();
+    switch (s)
+    {
+    case START_V1:
+        return n.path.front().v1;
+    case START_V2:
+        return n.path.front().v2;
+    case END_V1:
+        return n.path.back().v1;
+    default:
+        return n.path.back().v2;
+    }
+}
+
+Coord exitPoint(const Node &n, State s) // The last waypoint flown in the subregion for start state s
+{
+    if (n.path.size() == 0)
+        return n.p->center();
+    switch (s)
+    {
+    case START_V1:
+        return n.path.back().v2;
+    case START_V2:
+        return n.path.back().v1;
+    case END_V1:
+        return n.path.front().v2;
+    default:
+        return n.path.front().v1;
+    }
+}
+
+inline size_t jointIndex(unsigned int n, unsigned int i, State a, unsigned int j, State b)
+{ return (((size_t)i * 4 + a) * n + j) * 4 + b; }
+
+void jointDistances(Graph<Node, float_type> &g, std::vector<float_type> &table) // Fill the 4x4 joint point distance table for every pair of nodes
+{
+    const unsigned int n = g.size();
+    table.assign(n * n * 16, 0);
+    for (unsigned int i = 0; i < n; ++i)
+        for (unsigned int j = 0; j < n; ++j)
         {
-            g.v[*it].startState = START_V2;
-            dist = distance(joint, g.v[*it].path.front().v2);
+            if (i == j)
+                continue;
+            // Keep preferring adjacent subregions like computeGraph() does so transitions stay inside the search area
+            float_type penalty = g.hasEdge(i, j) ? 0 : INF;
+            for (unsigned int a = 0; a < 4; ++a)
+                for (unsigned int b = 0; b < 4; ++b)
+                    table[jointIndex(n, i, (State)a, j, (State)b)] = penalty + distance(exitPoint(g.v[i], (State)a), entryPoint(g.v[j], (State)b));
         }
-        if (dist > distance(joint, g.v[*it].path.back().v1))
+}
+
+void computeStates(std::list<unsigned int> &path, Graph<Node, float_type> &g) // Determine the start states of subregions in minimum traversal to optimally link the path
+{
+    // Dynamic program over (position along path, state). For a fixed order this is exact and only costs 16 comparisons per node
+    assert(path.size() > 0);
+    std::vector<float_type> table;
+    jointDistances(g, table);
+    std::vector<unsigned int> order(path.begin(), path.end());
+    std::vector<float_type> cost(order.size() * 4, 0); // cost[k * 4 + s] is the min length up to node k entered in state s
+    std::vector<unsigned int> parent(order.size() * 4, 0);
+    for (unsigned int k = 1; k < order.size(); ++k)
+        for (unsigned int b = 0; b < 4; ++b)
         {
-            g.v[*it].startState = END_V1;
-            dist = distance(joint, g.v[*it].path.back().v1);
+            float_type minCost = -1;
+            for (unsigned int a = 0; a < 4; ++a)
+            {
+                float_type currCost = cost[(k - 1) * 4 + a] + table[jointIndex(g.size(), order[k - 1], (State)a, order[k], (State)b)];
+                if (currCost < minCost || minCost == -1)
+                {
+                    minCost = currCost;
+                    parent[k * 4 + b] = a;
+                }
+            }
+            cost[k * 4 + b] = minCost;
         }
-        if (dist > distance(joint, g.v[*it].path.back().v2))
-            g.v[*it].startState = END_V2;
+    unsigned int state = 0;
+    unsigned int last = order.size() - 1;
+    for (unsigned int s = 1; s < 4; ++s)
+        if (cost[last * 4 + s] < cost[last * 4 + state])
+            state = s;
+    for (int k = last; k >= 0; --k)
+    {
+        g.v[order[k]].startState = (State)state;
+        state = parent[k * 4 + state];
     }
 }
 
-std::list<Coord> searchPath(const Polygon &p) // Generates a search path for arbitrary polygon p
+std::list<unsigned int> jointTraversal(Graph<Node, float_type> &g, int first) // Generalized TSP over (visited set, last node, last state)
 {
-    std::list<Coord> path;
+    const unsigned int n = g.size();
+    assert(n > 0 && first < (int)n);
+    assert(first < 0 || n <= JOINT_TRAVERSAL_MAX);
+    if (n > JOINT_TRAVERSAL_MAX) // Too large for the exact search so fix the order first, then pick the states
+    {
+        std::list<unsigned int> travOrder = minTraversal(g);
+        computeStates(travOrder, g);
+        return travOrder;
+    }
+    std::vector<float_type> table;
+    jointDistances(g, table);
+    const size_t numSets = (size_t)1 << n;
+    const unsigned int numLast = n * 4; // Each (node, state) pair the path can end on
+    // cost[set * numLast + last * 4 + state] is the min length visiting the nodes in set and ending at last entered in state, or -1 if unreachable
+    std::vector<float_type> cost(numSets * numLast, -1);
+    std::vector<unsigned char> parent(numSets * numLast, 0); // The (node, state) pair visited before, packed as node * 4 + state
+    for (unsigned int i = 0; i < n; ++i)
+        if (first < 0 || (int)i == first) // A fixed start is the only path of one node
+            for (unsigned int s = 0; s < 4; ++s)
+                cost[((size_t)1 << i) * numLast + i * 4 + s] = 0;
+    for (size_t set = 1; set < numSets; ++set)
+    {
+        for (unsigned int last = 0; last < numLast; ++last)
+        {
+            float_type currCost = cost[set * numLast + last];
+            if (currCost < 0)
+                continue;
+            for (unsigned int next = 0; next < n; ++next)
+            {
+                if (set & ((size_t)1 << next))
+                    continue;
+                size_t nextSet = set | ((size_t)1 << next);
+                for (unsigned int s = 0; s < 4; ++s)
+                {
+                    size_t nextIndex = nextSet * numLast + next * 4 + s;
+                    float_type nextCost = currCost + table[jointIndex(n, last / 4, (State)(last % 4), next, (State)s)];
+                    if (nextCost < cost[nextIndex] || cost[nextIndex] < 0)
+                    {
+                        cost[nextIndex] = nextCost;
+                        parent[nextIndex] = last;
+                    }
+                }
+            }
+        }
+    }
+    // Find the cheapest final (node, state) then walk the parents back to the start
+    size_t set = numSets - 1;
+    unsigned int last = numLast;
+    for (unsigned int i = 0; i < numLast; ++i) // With a fixed start the paths ending on it are unreachable
+        if (cost[set * numLast + i] >= 0 && (last == numLast || cost[set * numLast + i] < cost[set * numLast + last]))
+            last = i;
+    std::list<unsigned int> travOrder;
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        unsigned int node = last / 4;
+        g.v[node].startState = (State)(last % 4);
+        travOrder.push_front(node);
+        unsigned int prev = parent[set * numLast + last];
+        set &= ~((size_t)1 << node);
+        last = prev;
+    }
+    return travOrder;
+}
+
+PathStream searchPathStream(const Polygon &p, const BoundaryIndex *boundary, const PlannerConfig &config, PlanMemo *memo) // Plans a search path for arbitrary polygon p
+{
+    PathStream stream(boundary);
     std::list<Polygon> subregions;
     unsigned int numConcave = 0;
-    decompose(p, subregions); // Decompose p into subregions
-    mergeSubregions(subregions); // Merge adjacent subregions with the same width
+    if (memo != NULL)
+        memo->begin(config);
+    {
+        PROFILE_SCOPE(PHASE_DECOMPOSE);
+        decompose(p, subregions, memo); // Decompose p into subregions
+    }
+    std::vector<std::vector<unsigned int> > adjacency; // Subregions that share an edge, found while merging
+    {
+        PROFILE_SCOPE(PHASE_MERGE);
+        mergeSubregions(subregions, &adjacency); // Merge adjacent subregions with the same width
+    }
     for (unsigned int i = 0; i < p.v.size(); ++i)
         if (isConcave(p, i))
             ++numConcave;
     if (numConcave == 0) // If the polygon is already convex, just traverse it
     {
-        std::list<Edge> trav;
-        traverse(p, trav);
-        for (std::list<Edge>::iterator e = trav.begin(); e != trav.end(); ++e)
-        {
-            path.push_back(e->v1);
-            path.push_back(e->v2);
-        }
-        return path;
+        PROFILE_SCOPE(PHASE_TRAVERSE);
+        std::vector<Edge> trav;
+        if (memo != NULL)
+            memo->traverse(p, trav, config);
+        else
+            traverse(p, trav, config);
+        stream.addSubregion(std::move(trav), START_V1);
+        return stream;
     }
     Graph<Node, float_type> g(subregions.size());
     // Construct the list of nodes
@@ -1166,54 +2495,164 @@ std::list<Coord> searchPath(const Polygon &p) // Generates a search path for arb
         ++i;
     }
     i = 0;
-    while (i < subregions.size()) // Get the traversals for each subregion
     {
-        traverse(*(g.v[i].p), g.v[i].path);
-        ++i;
+        PROFILE_SCOPE(PHASE_TRAVERSE);
+        while (i < subregions.size()) // Get the traversals for each subregion
+        {
+            if (memo != NULL)
+                memo->traverse(*(g.v[i].p), g.v[i].path, config);
+            else
+                traverse(*(g.v[i].p), g.v[i].path, config);
+            ++i;
+        }
     }
-    computeGraph(g); // Compute the edges and weights
-    std::list<unsigned int> travOrder = minTraversal(g); // Get the min traversal for the graph
-    computeStates(travOrder, g); // Compute the start states of each node
-    for (std::list<unsigned int>::iterator it = travOrder.begin(); it != travOrder.end(); ++it)
+    // Keep the previous order if the subregions still connect the same way. Only the start states depend on
+    // the sweep legs of a subregion an edit moved, so they are solved again unless every subregion is unchanged
+    bool sameAdjacency = memo != NULL && !memo->order.empty() && memo->subregions.size() == subregions.size() && memo->adjacency == adjacency;
+    bool sameSubregions = sameAdjacency;
+    for (i = 0; sameSubregions && i < subregions.size(); ++i)
+        sameSubregions = memo->subregions[i] == g.v[i].p->v;
+    if (!sameSubregions)
+    {
+        PROFILE_SCOPE(PHASE_GRAPH);
+        computeGraph(g, &adjacency); // Compute the edges and weights
+    }
+    std::list<unsigned int> travOrder;
     {
-        unsigned int j = *it;
-        if (g.v[j].path.size() > 0)
+        PROFILE_SCOPE(PHASE_ORDER);
+        if (sameSubregions)
         {
-            switch (g.v[j].startState) // Write out each subregion's path. The start state of p will affect the order in which waypoints are read.
-            {
-            case START_V1: // Read search path as normal. End point is final edge v2.
-                for (std::list<Edge>::iterator e = g.v[j].path.begin(); e != g.v[j].path.end(); ++e)
-                {
-                    path.push_back(e->v1);
-                    path.push_back(e->v2);
-                }
-                break;
-            case START_V2: // Read edges in order, but vertices in reverse. End point is final edge v1.
-                for (std::list<Edge>::iterator e = g.v[j].path.begin(); e != g.v[j].path.end(); ++e)
-                {
-                    path.push_back(e->v2);
-                    path.push_back(e->v1);
-                }
-                break;
-            case END_V1: // Read edges in reverse but vertices in order. End point is start edge v2.
-                for (std::list<Edge>::reverse_iterator e = g.v[j].path.rbegin(); e != g.v[j].path.rend(); ++e)
-                {
-                    path.push_back(e->v1);
-                    path.push_back(e->v2);
-                }
-                break;
-            case END_V2: // Read edges in reverse and vertices in reverse. End point is start edge v1.
-                for (std::list<Edge>::reverse_iterator e = g.v[j].path.rbegin(); e != g.v[j].path.rend(); ++e)
-                {
-                    path.push_back(e->v2);
-                    path.push_back(e->v1);
-                }
-                break;
-            default: // Unknown state
-                std::cout << "Warning: Unknown state encountered\n";
-            }
+            travOrder = memo->order;
+            for (i = 0; i < subregions.size(); ++i)
+                g.v[i].startState = memo->states[i];
+        }
+        else if (sameAdjacency)
+        {
+            travOrder = memo->order;
+            computeStates(travOrder, g);
+        }
+        else
+            travOrder = jointTraversal(g); // Get the min traversal and start states for the graph
+        if (memo != NULL)
+            memo->reusedOrder = sameAdjacency;
+    }
+    if (memo != NULL && !sameSubregions)
+    {
+        memo->subregions.resize(subregions.size());
+        memo->states.resize(subregions.size());
+        for (i = 0; i < subregions.size(); ++i)
+        {
+            memo->subregions[i] = g.v[i].p->v;
+            memo->states[i] = g.v[i].startState;
+        }
+        memo->adjacency = adjacency;
+        memo->order = travOrder;
+    }
+    std::vector<unsigned int> position(subregions.size()); // Where each subregion is in the traversal
+    i = 0;
+    for (std::list<unsigned int>::iterator it = travOrder.begin(); it != travOrder.end(); ++it) // The start state of each subregion decides the order its waypoints are read
+    {
+        stream.addSubregion(std::move(g.v[*it].path), g.v[*it].startState);
+        position[*it] = i++;
+    }
+    stream.adjacency.resize(subregions.size()); // Kept so a resumed plan still prefers adjacent subregions
+    for (i = 0; i < subregions.size(); ++i)
+        for (unsigned int k = 0; k < adjacency[i].size(); ++k)
+            stream.adjacency[position[i]].push_back(position[adjacency[i][k]]);
+    return stream;
+}
+
+PathStream resumePathStream(const PathStream &plan, size_t completedLegs, const Coord &position) // Plans the unflown part of a search path from the current position
+{
+    PathStream stream(plan.boundary);
+    stream.setStart(position);
+    // Node 0 is the current position as a single leg of zero length so its exit is the position in every state
+    std::vector<Node> nodes(1, Node(NULL, std::vector<Edge>(1, Edge(position, position))));
+    std::vector<unsigned int> regions; // The plan position of each node after the first
+    size_t skip = completedLegs;
+    for (unsigned int r = 0; r < plan.legs.size(); ++r)
+    {
+        const std::vector<Edge> &path = plan.legs[r];
+        State s = plan.states[r];
+        if (skip >= path.size()) // Already flown or has no legs
+        {
+            skip -= path.size();
+            continue;
         }
+        // Drop the legs flown in the subregion the drone stopped in. States starting at the end edge fly the legs backwards
+        if (skip == 0)
+            nodes.push_back(Node(NULL, path, s));
+        else if (s == END_V1 || s == END_V2)
+            nodes.push_back(Node(NULL, std::vector<Edge>(path.begin(), path.end() - skip), s));
+        else
+            nodes.push_back(Node(NULL, std::vector<Edge>(path.begin() + skip, path.end()), s));
+        regions.push_back(r);
+        skip = 0;
+    }
+    if (regions.empty())
+        return stream;
+    Graph<Node, float_type> g(std::move(nodes));
+    const unsigned int n = g.size();
+    const bool knownAdjacency = plan.adjacency.size() == plan.legs.size();
+    std::vector<int> node(plan.legs.size(), -1); // The node of each plan position that has legs left
+    for (unsigned int i = 1; i < n; ++i)
+        node[regions[i - 1]] = i;
+    for (unsigned int i = 1; i < n; ++i)
+    {
+        g.setEdge(0, i); // The drone can go anywhere from where it is
+        if (!knownAdjacency)
+        {
+            for (unsigned int j = 1; j < n; ++j)
+                if (i != j)
+                    g.setEdge(i, j);
+            continue;
+        }
+        const std::vector<unsigned int> &adjacent = plan.adjacency[regions[i - 1]];
+        for (unsigned int k = 0; k < adjacent.size(); ++k)
+            if (node[adjacent[k]] >= 0)
+                g.setEdge(i, node[adjacent[k]]);
+    }
+    std::list<unsigned int> travOrder;
+    {
+        PROFILE_SCOPE(PHASE_ORDER);
+        if (n <= JOINT_TRAVERSAL_MAX)
+            travOrder = jointTraversal(g, 0);
+        else // Keep the planned order, which is already a good one, and only fit the start states to the new start
+        {
+            for (unsigned int i = 0; i < n; ++i)
+                travOrder.push_back(i);
+            computeStates(travOrder, g);
+        }
+    }
+    travOrder.pop_front(); // The current position
+    std::vector<unsigned int> resumed(n); // Where each node is in the resumed traversal
+    unsigned int i = 0;
+    for (std::list<unsigned int>::iterator it = travOrder.begin(); it != travOrder.end(); ++it)
+    {
+        stream.addSubregion(std::move(g.v[*it].path), g.v[*it].startState);
+        resumed[*it] = i++;
+    }
+    if (knownAdjacency)
+    {
+        stream.adjacency.resize(n - 1);
+        for (i = 1; i < n; ++i)
+            for (unsigned int j = 1; j < n; ++j)
+                if (g.hasEdge(i, j))
+                    stream.adjacency[resumed[i]].push_back(resumed[j]);
     }
+    return stream;
+}
+
+std::vector<Coord> searchPath(const Polygon &p, const BoundaryIndex *boundary, const PlannerConfig &config) // Generates a search path for arbitrary polygon p
+{
+    PathStream stream = searchPathStream(p, boundary, config);
+    std::vector<Coord> path;
+    path.reserve(stream.sweepSize());
+    Coord c;
+    while (stream.next(c))
+        path.push_back(c);
+    if (stream.failed)
+        path.clear();
     return path;
 }
 
@@ -1228,60 +2667,132 @@ bool clockwise(const std::vector<Coord> &v) // Return true if the coordinates ar
     return sum > 0;
 }
 
-struct Comp // Simple comparator for sorting in pathTo
+bool inside(const Coord &c, const Polygon &p) // Ray casting point in polygon test
 {
-    Coord point;
-    
-    Comp(Coord c)
-    { point = c; }
-    bool operator()(std::pair<unsigned int, Coord> it1, std::pair<unsigned int, Coord> it2)
-    { return distance(point, it1.second) < distance(point, it2.second); }
-    bool operator()(Coord c1, Coord c2)
-    { return distance(point, c1) < distance(point, c2); }
-};
+    bool result = false;
+    for (unsigned int i = 0, j = p.size() - 1; i < p.size(); j = i++)
+        if (((p.v[i].y > c.y) != (p.v[j].y > c.y)) &&
+            (c.x < (p.v[j].x - p.v[i].x) * (c.y - p.v[i].y) / (p.v[j].y - p.v[i].y) + p.v[i].x))
+            result = !result;
+    return result;
+}
 
-void pathToHelp(std::list<Coord> &path, std::list<Coord>::iterator point1, std::list<Coord>::iterator point2, const Polygon &boundary) // Workhorse function for pathTo to recursively unfold intersections
+bool visible(const Coord &point1, const Coord &point2, const Polygon &boundary) // Check if the segment between two points stays inside the boundary
 {
-    Edge line(*point1, *point2);
+    Edge line(point1, point2);
     Coord inter;
-    std::vector<std::pair<unsigned int, Coord> > intersects;
-    std::list<Coord> result;
-    Comp comp(*point1);
-    for (unsigned int i = 0; i < boundary.size(); ++i) // Check for intersections and store them
+    for (unsigned int i = 0; i < boundary.size(); ++i)
         if (intersection(line, boundary.edge(i), inter))
-            intersects.push_back(std::make_pair(i, inter));
-    if (intersects.size() == 0)
-        return;
-    else
+            return false;
+    // The segment may lie entirely outside if both endpoints do so also check the midpoint
+    return inside((point1 + point2) * 0.5, boundary);
+}
+
+void inflate(const Polygon &boundary, float_type radius, std::vector<Coord> &verts) // Offset the concave vertices of the boundary inward by radius
+{
+    // Shortest paths inside a polygon only ever bend around its concave vertices so those are the only ones we need
+    verts.clear();
+    for (unsigned int i = 0; i < boundary.size(); ++i)
     {
-        std::sort(intersects.begin(), intersects.end(), comp); // Sort intersects by distance from point1
-        for (std::vector<std::pair<unsigned int, Coord> >::iterator it = intersects.begin(); it != intersects.end(); ++it) // Offset each current intersection by RADIUS in the desired direction
-        {
-            it->second.x += RADIUS * cos(boundary.edge(it->first).theta() + (PI / 2.0));
-            it->second.y += RADIUS * sin(boundary.edge(it->first).theta() + (PI / 2.0));
-        }
-        // OPTIONAL: Add check to see if the offset intersects still lie within the boundary. If not, remove them. If intersects.size() becomes 0, return.
-        for (std::vector<std::pair<unsigned int, Coord> >::iterator it = intersects.begin(); it != intersects.end(); ++it) // Add the offset intersections to the path
-            path.insert(point2, it->second);
-        for (std::list<Coord>::iterator it = path.begin(); std::next(it) != path.end(); ++it) // Unfold intersections in each of the subpaths
-            pathToHelp(path, it, std::next(it), boundary);
+        if (!isConcave(boundary, i))
+            continue;
+        Coord prev = boundary.v[(i + boundary.size() - 1) % boundary.size()];
+        Coord next = boundary.v[(i + 1) % boundary.size()];
+        Coord d1 = (boundary.v[i] - prev) * (1.0 / distance(prev, boundary.v[i])); // Unit direction of the incoming edge
+        Coord d2 = (next - boundary.v[i]) * (1.0 / distance(boundary.v[i], next)); // Unit direction of the outgoing edge
+        Coord n1(-d1.y, d1.x), n2(-d2.y, d2.x); // Inward normals since the boundary is CCW
+        Coord bisector = n1 + n2;
+        Coord offset;
+        // Place the vertex where the two edges offset by radius meet. Clamp the miter for very sharp corners
+        if (bisector.vectorLength() < EPSILON)
+            offset = d1 * radius;
+        else if (1 + n1 * n2 < 0.5)
+            offset = bisector * (2 * radius / bisector.vectorLength());
+        else
+            offset = bisector * (radius / (1 + n1 * n2));
+        Coord vert = boundary.v[i] + offset;
+        if (!inside(vert, boundary))
+            continue;
+        bool clear = true; // The offset can land near an edge other than the two it was offset from
+        for (unsigned int j = 0; j < boundary.size() && clear; ++j)
+            clear = segmentDistance(vert, boundary.edge(j)) >= radius * (1 - 1e-9);
+        if (clear)
+            verts.push_back(vert);
     }
 }
 
-std::list<Coord> pathTo(const Coord &point1, const Coord &point2, const Polygon &boundary) // Generate path from point1 to point2 that does not intersect boundary
+bool pathTo(const Coord &point1, const Coord &point2, const Polygon &boundary, std::vector<Coord> &path, const PlannerConfig &config) // Generate path from point1 to point2 that does not intersect boundary
+{ return pathTo(point1, point2, BoundaryIndex(boundary, config.radius), path); }
+
+bool pathTo(const Coord &point1, const Coord &point2, const BoundaryIndex &index, std::vector<Coord> &path) // Generate path from point1 to point2 using the cached boundary geometry
 {
-    std::list<Coord> result;
-    result.push_back(point1);
-    result.push_back(point2);
-    std::list<Coord>::iterator it1 = result.begin();
-    std::list<Coord>::iterator it2 = std::next(it1);
-    pathToHelp(result, it1, it2, boundary);
-    result.pop_front(); // Remove the terminal points
-    result.pop_back();
-    return result;
+    // A* over the cached visibility graph with the two end points connected in
+    PROFILE_SCOPE(PHASE_TRANSIT);
+    path.clear();
+    if (index.visible(point1, point2))
+        return true;
+    PROFILE_COUNT(COUNT_TRANSITS, 1);
+    TRACE_SPAN("astar", "vertices", index.graph.size());
+    const unsigned int numVerts = index.graph.size();
+    // Nodes 0 to numVerts - 1 are the inflated vertices, numVerts is point1, and numVerts + 1 is point2
+    const unsigned int start = numVerts, goal = numVerts + 1;
+    std::vector<Coord> verts(index.graph.v);
+    verts.push_back(point1);
+    verts.push_back(point2);
+    std::vector<bool> startVis(numVerts), goalVis(numVerts); // Visibility of each inflated vertex from the end points
+    for (unsigned int i = 0; i < numVerts; ++i)
+    {
+        startVis[i] = index.visible(point1, verts[i]);
+        goalVis[i] = index.visible(verts[i], point2);
+    }
+    std::vector<float_type> cost(verts.size(), -1); // Length of the shortest known path from point1 or -1 if not yet reached
+    std::vector<int> parent(verts.size(), -1);
+    std::vector<bool> closed(verts.size(), false);
+    // Min heap of (estimated total length, vertex)
+    std::priority_queue<std::pair<float_type, unsigned int>, std::vector<std::pair<float_type, unsigned int> >, std::greater<std::pair<float_type, unsigned int> > > open;
+    cost[start] = 0;
+    open.push(std::make_pair(distance(point1, point2), start));
+    while (!open.empty())
+    {
+        unsigned int curr = open.top().second;
+        open.pop();
+        if (closed[curr])
+            continue;
+        closed[curr] = true;
+        PROFILE_COUNT(COUNT_EXPANSIONS, 1);
+        if (curr == goal)
+            break;
+        // Relax in order of vertex index like a scan over every vertex would
+        auto relax = [&](unsigned int next, float_type length)
+        {
+            float_type nextCost = cost[curr] + length;
+            if (!closed[next] && (nextCost < cost[next] || cost[next] < 0))
+            {
+                cost[next] = nextCost;
+                parent[next] = curr;
+                open.push(std::make_pair(nextCost + distance(verts[next], point2), next));
+            }
+        };
+        if (curr == start) // The direct line to the goal was already ruled out
+        {
+            for (unsigned int next = 0; next < numVerts; ++next)
+                if (startVis[next])
+                    relax(next, distance(point1, verts[next]));
+            continue;
+        }
+        index.graph.forEachNext(curr, relax);
+        if (goalVis[curr])
+            relax(goal, distance(verts[curr], point2));
+    }
+    if (parent[goal] == -1) // Every route leaves the boundary or comes too close to it
+        return false;
+    for (int i = parent[goal]; i != (int)start; i = parent[i]) // Walk back from the goal leaving out the terminal points
+        path.push_back(verts[i]);
+    std::reverse(path.begin(), path.end());
+    return true;
 }
 
-void naiveTraverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse the polygon using a simple East-West traversal
+void naiveTraverse(const Polygon &p, std::vector<Edge> &waypoints, const PlannerConfig &config) // Traverse the polygon using a simple East-West traversal
 {
     // The logic for this is just a slight modification of traverse()
     assert(p.size() > 2);
@@ -1292,6 +2803,11 @@ void naiveTraverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse the
     for (unsigned int i = 1; i < p.size(); ++i)
         if (p.v[i].y < minY)
             minY = p.v[i].y;
+    float_type maxY = p.v[0].y;
+    for (unsigned int i = 1; i < p.size(); ++i)
+        if (p.v[i].y > maxY)
+            maxY = p.v[i].y;
+    waypoints.reserve(waypoints.size() + (size_t)((maxY - minY) / (config.offset / 2.0)) + 1); // One sweep leg per half offset
     // Define infinite horizontal sweep line
     sweepLine.v1 = Coord(-INF, minY);
     sweepLine.v2 = Coord(INF, minY);
@@ -1303,9 +2819,9 @@ void naiveTraverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse the
         bool operator()(Coord &c1, Coord &c2)
         { return c1.x < c2.x; }
     } cmp; // Compare the x values of coordinates
-    // Repeatedly find the intersections of the sweep line + OFFSET and store the intersections as waypoints until we do not find anymore intersections.
-    // Initially offset the position of the sweep line by OFFSET / 2
-    sweepLine.v1.y += (OFFSET / 2.0); sweepLine.v2.y += (OFFSET / 2.0);
+    // Repeatedly find the intersections of the sweep line + offset and store the intersections as waypoints until we do not find anymore intersections.
+    // Initially offset the position of the sweep line by half the offset
+    sweepLine.v1.y += (config.offset / 2.0); sweepLine.v2.y += (config.offset / 2.0);
     do
     {
         found = false;
@@ -1330,8 +2846,8 @@ void naiveTraverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse the
             // Shift waypoints inward to account for turn radius
             // Because we sorted, the waypoints will always be ordered left-right
             // Correct the x-coord
-            inter2.x -= CORRECTION;
-            inter1.x += CORRECTION;
+            inter2.x -= config.correction;
+            inter1.x += config.correction;
             // Check if the waypoints have crossed each other after correction
             Edge afterCorr(inter1, inter2); // The path after correction
             if (afterCorr.v1.x >= afterCorr.v2.x)
@@ -1346,35 +2862,45 @@ void naiveTraverse(const Polygon &p, std::list<Edge> &waypoints) // Traverse the
                     waypoints.push_back(Edge(inter2, inter1));
             }
         }
-        // OFFSET the sweep line
-        sweepLine.v1.y += (OFFSET / 2.0); sweepLine.v2.y += (OFFSET / 2.0);
+        // Offset the sweep line
+        sweepLine.v1.y += (config.offset / 2.0); sweepLine.v2.y += (config.offset / 2.0);
         ++j;
     } while (found);
 }
 
-std::list<Coord> naivePath(const Polygon &p)
+PathStream naivePathStream(const Polygon &p, const PlannerConfig &config) // Plans a naive search path for polygon p
 {
-    std::list<Edge> waypoints;
-    std::list<Coord> path;
-    naiveTraverse(p, waypoints);
-    for (std::list<Edge>::iterator e = waypoints.begin(); e != waypoints.end(); ++e)
+    PathStream stream;
+    std::vector<Edge> waypoints;
     {
-        path.push_back(e->v1);
-        path.push_back(e->v2);
+        PROFILE_SCOPE(PHASE_TRAVERSE);
+        naiveTraverse(p, waypoints, config);
     }
+    stream.addSubregion(std::move(waypoints), START_V1);
+    return stream;
+}
+
+std::vector<Coord> naivePath(const Polygon &p, const PlannerConfig &config)
+{
+    PathStream stream = naivePathStream(p, config);
+    std::vector<Coord> path;
+    path.reserve(stream.sweepSize());
+    Coord c;
+    while (stream.next(c))
+        path.push_back(c);
     return path;
 }
 
 // int main(int argc, char **argv) // Test driver
 // {
-//     // Remember to change the value of OFFSET and CORRECTION in Config.h
+//     // Remember to set the offset and correction in the PlannerConfig
 //     Polygon p;
 //     p.addVert(Coord(0, 0));
 //     p.addVert(Coord(10, 0));
 //     p.addVert(Coord(10, 5));
 //     p.addVert(Coord(5, 2.5));
 //     p.addVert(Coord(0, 10));
-//     std::list<Coord> path = naivePath(p);
+//     std::vector<Coord> path = naivePath(p);
 //     std::cout << path.size() << std::endl;
 //     for (auto &c : path)
 //         std::cout << "(" << c.x << "," << c.y << ")\n";
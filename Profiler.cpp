@@ -0,0 +1,365 @@
+/**
+ * @file Profiler.cpp
+ * @brief Scoped phase timers, event counters and a span trace for finding where a planning run spends its time.
+ * The hooks compile to nothing unless PROFILE is defined as 1. Each thread records into its own slot
+ * without taking a lock and the slots are only summed when the report is written. When tracing is
+ * switched on the begin and end of every span are also kept and can be written in the Chrome trace
+ * event format for viewing in chrome://tracing or Perfetto.
+ * @see PROFILE
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdint>
+#include "Config.h"
+
+/**
+ * @brief The timed phases of a planning run.
+ * Phases may nest. Writing the output includes the transits that are routed while it is read.
+ */
+enum Phase
+{
+    PHASE_PARSE,
+    PHASE_CONVERT,
+    PHASE_BOUNDARY,
+    PHASE_DECOMPOSE,
+    PHASE_MERGE,
+    PHASE_TRAVERSE,
+    PHASE_GRAPH,
+    PHASE_ORDER,
+    PHASE_TRANSIT,
+    PHASE_WRITE,
+    NUM_PHASES
+};
+
+/**
+ * @brief The counted events of a planning run.
+ */
+enum Counter
+{
+    COUNT_SPLITS, // Candidate splits scored by decompose
+    COUNT_INTERSECTIONS, // Calls to intersection()
+    COUNT_PERMUTATIONS, // Orders visited by bruteForceTraversal
+    COUNT_TRANSITS, // Calls to pathTo that needed a search
+    COUNT_EXPANSIONS, // Vertices expanded by the A* search in pathTo
+    NUM_COUNTERS
+};
+
+/**
+ * @brief Names of the phases as written to the report.
+ * @see Phase
+ */
+const char *const PHASE_NAMES[NUM_PHASES] = {"parse", "convert", "boundary", "decompose", "merge", "traverse",
+                                             "graph", "order", "transit", "write"};
+/**
+ * @brief Names of the counters as written to the report.
+ * @see Counter
+ */
+const char *const COUNTER_NAMES[NUM_COUNTERS] = {"candidate_splits", "intersections", "permutations", "transits",
+                                                 "astar_expansions"};
+
+/**
+ * @brief The begin or end of a traced span.
+ */
+struct TraceEvent
+{
+    /**
+     * @brief Name of the span. Must be a string literal.
+     */
+    const char *name;
+    /**
+     * @brief 'B' for begin or 'E' for end.
+     */
+    char type;
+    /**
+     * @brief Nanoseconds since the run started.
+     */
+    uint64_t time;
+    /**
+     * @brief Names of up to two arguments recorded with a begin event. Unused names are NULL.
+     */
+    const char *argNames[2];
+    /**
+     * @brief Values of the arguments.
+     */
+    long long argValues[2];
+};
+
+/**
+ * @brief The times, counts and trace events recorded by one thread.
+ * Only the owning thread writes to a slot so updates are a relaxed load and store rather than a locked add.
+ */
+struct ProfileSlot
+{
+    std::atomic<uint64_t> nanos[NUM_PHASES];
+    std::atomic<uint64_t> calls[NUM_PHASES];
+    std::atomic<uint64_t> counts[NUM_COUNTERS];
+    /**
+     * @brief Trace events in the order this thread recorded them.
+     * @see TraceEvent
+     */
+    std::vector<TraceEvent> events;
+    /**
+     * @brief Thread id written to the trace.
+     */
+    unsigned int id;
+
+    ProfileSlot(unsigned int threadId = 0): id(threadId)
+    { clear(); }
+    /**
+     * @brief Reset every time and count to zero.
+     */
+    void clear()
+    {
+        for (unsigned int i = 0; i < NUM_PHASES; ++i)
+        {
+            nanos[i].store(0, std::memory_order_relaxed);
+            calls[i].store(0, std::memory_order_relaxed);
+        }
+        for (unsigned int i = 0; i < NUM_COUNTERS; ++i)
+            counts[i].store(0, std::memory_order_relaxed);
+        events.clear();
+    }
+    /**
+     * @brief Add to a value that only this thread writes.
+     */
+    static void add(std::atomic<uint64_t> &value, uint64_t n)
+    { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Collects the slots of every thread that has recorded anything.
+ */
+struct Profiler
+{
+    /**
+     * @brief Guards the list of slots. Only taken the first time a thread records and when reporting.
+     */
+    std::mutex mutex;
+    /**
+     * @brief One slot per thread. Slots outlive their threads so nothing recorded is lost.
+     */
+    std::vector<std::unique_ptr<ProfileSlot> > slots;
+    /**
+     * @brief When the run started.
+     */
+    std::chrono::steady_clock::time_point start;
+    /**
+     * @brief Whether spans are being kept for the trace.
+     */
+    std::atomic<bool> tracing;
+
+    Profiler(): start(std::chrono::steady_clock::now()), tracing(false)
+    {}
+    /**
+     * @brief Get the calling thread's slot, creating it on first use.
+     * @return the slot of the calling thread
+     */
+    ProfileSlot &local()
+    {
+        thread_local ProfileSlot *slot = NULL;
+        if (slot == NULL)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots.push_back(std::unique_ptr<ProfileSlot>(new ProfileSlot(slots.size())));
+            slot = slots.back().get();
+        }
+        return *slot;
+    }
+    /**
+     * @brief Get the time since the run started.
+     * @return the elapsed time in nanoseconds
+     */
+    uint64_t now() const
+    { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(); }
+    /**
+     * @brief Record the begin or end of a span on the calling thread if tracing is on.
+     * @param name name of the span
+     * @param type 'B' for begin or 'E' for end
+     * @param argName1 name of the first argument or NULL
+     * @param argValue1 value of the first argument
+     * @param argName2 name of the second argument or NULL
+     * @param argValue2 value of the second argument
+     */
+    void trace(const char *name, char type, const char *argName1 = NULL, long long argValue1 = 0,
+               const char *argName2 = NULL, long long argValue2 = 0)
+    {
+        if (!tracing.load(std::memory_order_relaxed))
+            return;
+        TraceEvent event;
+        event.name = name;
+        event.type = type;
+        event.time = now();
+        event.argNames[0] = argName1;
+        event.argNames[1] = argName2;
+        event.argValues[0] = argValue1;
+        event.argValues[1] = argValue2;
+        local().events.push_back(event);
+    }
+    /**
+     * @brief Clear everything recorded so far and restart the run clock.
+     */
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < slots.size(); ++i)
+            slots[i]->clear();
+        start = std::chrono::steady_clock::now();
+    }
+    /**
+     * @brief Write the totals of every thread as JSON.
+     * Phase times are in milliseconds and are summed over threads.
+     * @param path path of the report file
+     * @return true if the report was written, else false
+     */
+    bool writeReport(const std::string &path)
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "Error: Could not create profile report " << path << '\n';
+            return false;
+        }
+        uint64_t nanos[NUM_PHASES] = {0}, calls[NUM_PHASES] = {0}, counts[NUM_COUNTERS] = {0};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < slots.size(); ++i)
+            {
+                for (unsigned int j = 0; j < NUM_PHASES; ++j)
+                {
+                    nanos[j] += slots[i]->nanos[j].load(std::memory_order_relaxed);
+                    calls[j] += slots[i]->calls[j].load(std::memory_order_relaxed);
+                }
+                for (unsigned int j = 0; j < NUM_COUNTERS; ++j)
+                    counts[j] += slots[i]->counts[j].load(std::memory_order_relaxed);
+            }
+        }
+        file << "{\n  \"enabled\": " << (PROFILE ? "true" : "false") << ",\n";
+        file << "  \"total_ms\": " << now() / 1e6 << ",\n";
+        file << "  \"phases\": {\n";
+        for (unsigned int i = 0; i < NUM_PHASES; ++i)
+            file << "    \"" << PHASE_NAMES[i] << "\": {\"ms\": " << nanos[i] / 1e6 << ", \"calls\": " << calls[i] << "}"
+                 << (i + 1 < NUM_PHASES ? ",\n" : "\n");
+        file << "  },\n  \"counters\": {\n";
+        for (unsigned int i = 0; i < NUM_COUNTERS; ++i)
+            file << "    \"" << COUNTER_NAMES[i] << "\": " << counts[i] << (i + 1 < NUM_COUNTERS ? ",\n" : "\n");
+        file << "  }\n}\n";
+        return file.good();
+    }
+    /**
+     * @brief Write every recorded span in the Chrome trace event format.
+     * Call once the run is done since the threads' event lists are read without a lock.
+     * @param path path of the trace file
+     * @return true if the trace was written, else false
+     */
+    bool writeTrace(const std::string &path)
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "Error: Could not create trace file " << path << '\n';
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        bool first = true;
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            const std::vector<TraceEvent> &events = slots[i]->events;
+            for (size_t j = 0; j < events.size(); ++j)
+            {
+                file << (first ? "\n" : ",\n");
+                first = false;
+                // Timestamps are in microseconds. Write them as exact integers with the nanoseconds as a fraction since the
+                // stream's default precision would round long runs to milliseconds and break the nesting of short spans
+                file << "{\"name\": \"" << events[j].name << "\", \"ph\": \"" << events[j].type << "\", \"ts\": "
+                     << events[j].time / 1000 << '.' << std::setw(3) << std::setfill('0') << events[j].time % 1000
+                     << ", \"pid\": 1, \"tid\": " << slots[i]->id;
+                if (events[j].argNames[0] != NULL)
+                {
+                    file << ", \"args\": {\"" << events[j].argNames[0] << "\": " << events[j].argValues[0];
+                    if (events[j].argNames[1] != NULL)
+                        file << ", \"" << events[j].argNames[1] << "\": " << events[j].argValues[1];
+                    file << "}";
+                }
+                file << "}";
+            }
+        }
+        file << "\n]}\n";
+        return file.good();
+    }
+};
+
+/**
+ * @brief Get the profiler shared by the planner.
+ * @return the shared profiler
+ */
+Profiler& profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+/**
+ * @brief Adds the time between its construction and destruction to a phase.
+ */
+struct ScopedTimer
+{
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+
+    ScopedTimer(Phase p): phase(p), start(std::chrono::steady_clock::now())
+    { profiler().trace(PHASE_NAMES[phase], 'B'); }
+    ~ScopedTimer()
+    {
+        profiler().trace(PHASE_NAMES[phase], 'E');
+        ProfileSlot &slot = profiler().local();
+        ProfileSlot::add(slot.nanos[phase], std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        ProfileSlot::add(slot.calls[phase], 1);
+    }
+};
+
+/**
+ * @brief Records a span covering its lifetime in the trace.
+ * @see Profiler::trace
+ */
+struct TraceSpan
+{
+    const char *name;
+
+    TraceSpan(const char *spanName, const char *argName1 = NULL, long long argValue1 = 0,
+              const char *argName2 = NULL, long long argValue2 = 0): name(spanName)
+    { profiler().trace(name, 'B', argName1, argValue1, argName2, argValue2); }
+    ~TraceSpan()
+    { profiler().trace(name, 'E'); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if PROFILE
+/**
+ * @brief Time the rest of the enclosing scope as the given phase.
+ */
+#define PROFILE_SCOPE(phase) ScopedTimer PROFILE_CONCAT(scopedTimer, __LINE__)(phase)
+/**
+ * @brief Add n to the given counter.
+ */
+#define PROFILE_COUNT(counter, n) ProfileSlot::add(profiler().local().counts[counter], (n))
+/**
+ * @brief Trace the rest of the enclosing scope as a span. Takes a name and up to two name and value argument pairs.
+ */
+#define TRACE_SPAN(...) TraceSpan PROFILE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_COUNT(counter, n)
+#define TRACE_SPAN(...)
+#endif
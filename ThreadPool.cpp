@@ -0,0 +1,250 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief Work-stealing thread pool used to parallelize the planner.
+ * Each worker owns a deque of tasks. Workers pop their own newest task first and steal the oldest
+ * task from other workers when they run out. Threads waiting on a TaskGroup run queued tasks
+ * instead of blocking so tasks can safely spawn and wait on further tasks.
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <vector>
+#include "Config.h"
+
+/**
+ * @brief A fixed number of worker threads with one task deque each.
+ */
+struct ThreadPool
+{
+    /**
+     * @brief A task deque guarded by its own mutex.
+     */
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    /**
+     * @brief The worker threads.
+     */
+    std::vector<std::thread> workers;
+    /**
+     * @brief One deque per worker followed by a shared deque for tasks submitted from outside the pool.
+     */
+    std::vector<std::unique_ptr<WorkQueue> > queues;
+    /**
+     * @brief Number of tasks queued but not yet started.
+     */
+    std::atomic<unsigned int> queued;
+    /**
+     * @brief Set when the pool is being destroyed.
+     */
+    std::atomic<bool> stopping;
+    /**
+     * @brief Used by idle workers to sleep until a task is queued.
+     */
+    std::mutex sleepMutex;
+    /**
+     * @brief Signalled when a task is queued or the pool is stopping.
+     */
+    std::condition_variable cv;
+    /**
+     * @brief The pool the current thread works for, if any.
+     */
+    static thread_local ThreadPool *currentPool;
+    /**
+     * @brief Index of the current thread's deque in currentPool.
+     */
+    static thread_local unsigned int currentIndex;
+
+    /**
+     * @brief Start the worker threads.
+     * @param n number of worker threads. If 0, one less than the number of hardware threads is used since waiting threads also do work
+     */
+    ThreadPool(unsigned int n = 0): queued(0), stopping(false)
+    {
+        if (n == 0)
+            n = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+        for (unsigned int i = 0; i <= n; ++i)
+            queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+        for (unsigned int i = 0; i < n; ++i)
+            workers.push_back(std::thread([this, i]() { work(i); }));
+    }
+    /**
+     * @brief Stop and join the worker threads. Queued tasks are still run.
+     */
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (unsigned int i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+    /**
+     * @brief Queue a task. Tasks submitted by a worker go on its own deque, others go on the shared deque.
+     * @param task the task
+     */
+    void submit(std::function<void()> task)
+    {
+        WorkQueue &queue = *queues[currentPool == this ? currentIndex : workers.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+        ++queued;
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex); // Don't notify between a worker's check and its wait
+        }
+        cv.notify_one();
+    }
+    /**
+     * @brief Run a single queued task on the calling thread if there is one.
+     * Takes the newest task from the caller's own deque first, then the oldest from the shared deque and the other workers.
+     * @return true if a task was run, else false
+     */
+    bool runOne()
+    {
+        std::function<void()> task;
+        unsigned int self = (currentPool == this) ? currentIndex : workers.size();
+        for (unsigned int k = 0; k < queues.size() && !task; ++k)
+        {
+            unsigned int i = (self + k) % queues.size();
+            WorkQueue &queue = *queues[i];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+            if (i == self && self != workers.size()) // Own deque is used like a stack to keep recently split work hot in cache
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else // Steal the oldest task since it is likely the largest
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task)
+            return false;
+        --queued;
+        task();
+        return true;
+    }
+    /**
+     * @brief Run fn(0) through fn(n - 1) across the workers and the calling thread and wait for all of them to finish.
+     * Calls may complete in any order so fn must only write to state owned by its index.
+     * @param n number of indeces
+     * @param fn the function to run for each index
+     */
+    void parallelFor(unsigned int n, const std::function<void(unsigned int)> &fn);
+    /**
+     * @brief Worker loop.
+     * @param index index of the worker's own deque
+     */
+    void work(unsigned int index)
+    {
+        currentPool = this;
+        currentIndex = index;
+        while (true)
+        {
+            if (runOne())
+                continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            if (stopping && queued == 0)
+                return;
+            cv.wait(lock, [this]() { return stopping || queued > 0; }); // submit() notifies under sleepMutex so no wakeup is missed
+        }
+    }
+};
+
+thread_local ThreadPool *ThreadPool::currentPool = NULL;
+thread_local unsigned int ThreadPool::currentIndex = 0;
+
+/**
+ * @brief Get the thread pool shared by the planner.
+ * The pool is created on first use with THREADS workers.
+ * @return the shared thread pool
+ * @see THREADS
+ */
+ThreadPool& threadPool()
+{
+    static ThreadPool pool(THREADS);
+    return pool;
+}
+
+/**
+ * @brief A set of tasks that can be waited on together.
+ * Waiting runs other queued tasks rather than blocking so groups can be nested inside tasks.
+ */
+struct TaskGroup
+{
+    /**
+     * @brief The pool tasks are run on.
+     */
+    ThreadPool &pool;
+    /**
+     * @brief Number of spawned tasks that have not finished.
+     */
+    std::atomic<unsigned int> pending;
+
+    /**
+     * @brief Create an empty group.
+     * @param p the pool to run tasks on
+     */
+    TaskGroup(ThreadPool &p = threadPool()): pool(p), pending(0)
+    {}
+    /**
+     * @brief Wait for any remaining tasks.
+     */
+    ~TaskGroup()
+    { wait(); }
+    /**
+     * @brief Queue a task as part of the group.
+     * @param task the task. Anything it references must outlive wait()
+     */
+    void spawn(const std::function<void()> &task)
+    {
+        ++pending;
+        pool.submit([this, task]()
+                    {
+                        task();
+                        --pending;
+                    });
+    }
+    /**
+     * @brief Run queued tasks until every task in the group has finished.
+     */
+    void wait()
+    {
+        while (pending > 0)
+            if (!pool.runOne())
+                std::this_thread::yield();
+    }
+};
+
+void ThreadPool::parallelFor(unsigned int n, const std::function<void(unsigned int)> &fn)
+{
+    std::atomic<unsigned int> next(0); // The next unclaimed index
+    std::function<void()> claim = [&]()
+        {
+            for (unsigned int k = next++; k < n; k = next++)
+                fn(k);
+        };
+    TaskGroup group(*this);
+    // Helpers that start after every index is claimed return immediately
+    for (unsigned int i = 0; i < workers.size() && i + 1 < n; ++i)
+        group.spawn(claim);
+    claim();
+    group.wait();
+}
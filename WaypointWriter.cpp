@@ -0,0 +1,106 @@
+/**
+ * @file WaypointWriter.cpp
+ * @brief Buffered writer for the output waypoint file.
+ * Waypoints are written as comma separated ordinal, latitude, longitude and altitude fields with the
+ * latitude and longitude in degrees to 7 decimal places. Numbers are formatted with std::to_chars into
+ * a reusable buffer that is written out in one call once it fills up or the writer is flushed.
+ * @author Harvey Lin
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <charconv>
+#include "Config.h"
+
+/**
+ * @brief Number of decimal places written for latitudes and longitudes.
+ */
+#define WAYPOINT_PRECISION 7
+/**
+ * @brief Upper bound on the length of one formatted waypoint.
+ * A fixed point double has at most 309 integer digits so two of them plus the other fields fit.
+ */
+#define WAYPOINT_MAX_CHARS 1024
+
+/**
+ * @brief Formats waypoints into a byte buffer and writes them to a file.
+ */
+struct WaypointWriter
+{
+    /**
+     * @brief The output file.
+     */
+    std::ofstream file;
+    /**
+     * @brief Formatted bytes that have not been written yet.
+     */
+    std::vector<char> buffer;
+    /**
+     * @brief Number of bytes of buffer in use.
+     */
+    size_t used;
+    /**
+     * @brief Ordinal number of the next waypoint. Starts at 1.
+     */
+    unsigned int ordinal;
+
+    /**
+     * @brief Open the output file.
+     * @param path path of the file
+     * @param capacity size of the buffer in bytes. At least WAYPOINT_MAX_CHARS are used
+     */
+    WaypointWriter(const std::string &path, size_t capacity = 1 << 20): file(path.c_str(), std::ios::binary),
+                                                                       buffer(capacity < WAYPOINT_MAX_CHARS ? WAYPOINT_MAX_CHARS : capacity), used(0), ordinal(1)
+    {}
+    ~WaypointWriter()
+    { flush(); }
+    /**
+     * @brief Drop the waypoints not yet written and close the file.
+     */
+    void discard()
+    {
+        used = 0;
+        file.close();
+    }
+    /**
+     * @brief Check if the output file was opened successfully.
+     * @return true if the file is writable, else false
+     */
+    bool good() const
+    { return file.good(); }
+    /**
+     * @brief Append a waypoint.
+     * @param latitude the latitude in degrees
+     * @param longitude the longitude in degrees
+     * @param altitude the altitude in feet
+     */
+    void write(float_type latitude, float_type longitude, int altitude)
+    {
+        if (buffer.size() - used < WAYPOINT_MAX_CHARS)
+            flush();
+        char *curr = &buffer[used];
+        char *end = &buffer[0] + buffer.size();
+        if (ordinal != 1)
+            *curr++ = ',';
+        curr = std::to_chars(curr, end, ordinal).ptr;
+        *curr++ = ',';
+        curr = std::to_chars(curr, end, latitude, std::chars_format::fixed, WAYPOINT_PRECISION).ptr;
+        *curr++ = ',';
+        curr = std::to_chars(curr, end, longitude, std::chars_format::fixed, WAYPOINT_PRECISION).ptr;
+        *curr++ = ',';
+        curr = std::to_chars(curr, end, altitude).ptr;
+        used = curr - &buffer[0];
+        ++ordinal;
+    }
+    /**
+     * @brief Write out the buffered bytes.
+     */
+    void flush()
+    {
+        if (used > 0)
+            file.write(&buffer[0], used);
+        used = 0;
+    }
+};
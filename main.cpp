@@ -3,157 +3,68 @@
  * @brief Main driver for search path generation.
  * Pass the optional argument "naive" to use naive path generation with no decomposition.
  * Pass either no argument or "decomp" to use path generation with convex polygon decomposition.
+ * Parameters can be overridden with --key=value flags or loaded from a file with --config=path.
+ * Pass --profile_file=path to write a JSON report of the time spent in each phase. Builds without PROFILE
+ * defined as 1 write the report with every time and counter left at zero.
+ * Pass --trace_file=path to also write the spans of the run in the Chrome trace event format.
+ * Pass --batch_file=path to plan every mission listed in a manifest instead of the configured mission.
+ * Pass --socket_file=path to run as a daemon that answers planning requests on a Unix domain socket.
+ * @see PlannerConfig planMission runBatch PlanDaemon
  * @author Harvey Lin
  */
 
-#include "Polygon.cpp"
-#include "Conversions.cpp"
+#include "Mission.cpp"
+#include "Batch.cpp"
+#include "Daemon.cpp"
 #include <cctype>
-#include <iomanip>
 
 // ---
 // Main
 // ---
 int main(int argc, char **argv)
 {
-    if (argc > 2)
-    {
-        std::cout << "Error: Too many arguments passed\n";
+    PlannerConfig config; // Defaults from Config.h
+    std::vector<std::string> args; // Arguments that are not --key=value flags
+    if (!config.parseArgs(argc, argv, args))
         return 1;
-    }
-    
-    float_type altitude;
-    int ordinal;
-    float_type longitude, latitude;
-    char input[BUFF_MAX] = {};
-    Polygon searchArea; // The search grid polygon
-    Polygon boundary; // The boundary polygon
-    Coord lastMissionPoint; // The coordinate the drone will be in before pathing to the search grid
-    std::list<Coord> intermPath; // Path from lastMissionPoint to first point in search path
-    std::list<Coord> path; // The search path
-    std::ifstream missionFile(MISSION_FILE);
-    std::ifstream searchFile(SEARCH_FILE);
-    std::ifstream boundsFile(BOUNDS_FILE);
-    std::ofstream outFile(OUT_FILE);
-    unsigned int i = 1;
-    if (!missionFile)
+    if (args.size() > 1)
     {
-	std::cout << "Could not open mission file.\n";
-        return 1;
-    }
-    if (!searchFile)
-    {
-        std::cout << "Could not open search grid file.\n";
-        return 1;
-    }
-    if (!boundsFile)
-    {
-        std::cout << "Could not open boundary points file.\n";
-        return 1;
-    }
-    if (!outFile)
-    {
-        std::cout << "Could not create output file.\n";
+        std::cout << "Error: Too many arguments passed\n";
         return 1;
     }
-    
-    // Read from searchFile
-    // Use the first search grid coordinate read as the origin point of our Cartesian system
-    searchFile.getline(input, BUFF_MAX, ','); // Get the ordinal number
-    ordinal = (int) atof(input);
-    searchFile.getline(input, BUFF_MAX, ','); // Get latitude
-    latitude = toRadians(atof(input));
-    searchFile.getline(input, BUFF_MAX, ','); // Get longitude
-    longitude = toRadians(atof(input));
-    // Set the reference longitude, latitude, and cartesian coordinate
-    init(longitude, latitude);
-    computeBasis(); // Compute the basis vectors
-    searchArea.v.push_back(Coord(0, 0)); // Treat the first coordinate read as the origin
-    while(!searchFile.eof())
+    bool naive = false;
+    if (!args.empty())
     {
-	searchFile.getline(input, BUFF_MAX, ','); // Get the ordinal number
-	ordinal = (int) atof(input);
-	searchFile.getline(input, BUFF_MAX, ','); // Get latitude
-	latitude = toRadians(atof(input));
-	searchFile.getline(input, BUFF_MAX, ','); // Get longitude
-	longitude = toRadians(atof(input));
-	searchArea.v.push_back(GPStoCoord(longitude, latitude));
-    }
-    searchFile.close();
-    if (clockwise(searchArea.v)) // Ensure points are in counter-clockwise order
-	    std::reverse(searchArea.v.begin(), searchArea.v.end());
-    
-    // Read from boundaryFile
-    while(!boundsFile.eof())
-    {
-        boundsFile.getline(input, BUFF_MAX, ','); // Get the ordinal number
-        ordinal = (int) atof(input);
-        boundsFile.getline(input, BUFF_MAX, ','); // Get latitude
-        latitude = toRadians(atof(input));
-        boundsFile.getline(input, BUFF_MAX, ','); // Get longitude
-        longitude = toRadians(atof(input));
-        boundary.v.push_back(GPStoCoord(longitude, latitude));
-    }
-    boundsFile.close();
-    if (clockwise(boundary.v))
-	    std::reverse(boundary.v.begin(), boundary.v.end());
-
-    // Read from missionFile
-    outFile << std::fixed << std::setprecision(7);
-    while (!missionFile.eof())
-    {	
-        missionFile.getline(input, BUFF_MAX, ','); // Get the ordinal number
-        ordinal = (int) atof(input);
-        missionFile.getline(input, BUFF_MAX, ','); // Get latitude
-        latitude = toRadians(atof(input));
-        missionFile.getline(input, BUFF_MAX, ','); // Get longitude
-        longitude = toRadians(atof(input));
-        missionFile.getline(input, BUFF_MAX, ','); // Get altitude
-        altitude = atof(input);
-	if (i != 1)
-	    outFile << ',';
-        outFile << i << ',' << toDegrees(latitude) << ',' << toDegrees(longitude) << ',' << (int) altitude; // Duplicate MissionPointsParsed into our output file
-        ++i;
-    }
-    missionFile.close();
-    lastMissionPoint = GPStoCoord(longitude, latitude);
-
-    // Generate paths
-    if (argc == 1) // Default behavior for no arguments. Use decomposition
-        path = searchPath(searchArea);
-    else
-    {
-        if (strcmp(argv[1], "naive")) // Use naive traversal
-            path = naivePath(searchArea);
-        else if (strcmp(argv[1], "decomp")) // Use decomposition
-            path = searchPath(searchArea);
-        else
+        if (args[0] == "naive") // Use naive traversal
+            naive = true;
+        else if (args[0] != "decomp") // Default behavior for no arguments is decomposition
         {
             std::cout << "Error: Invalid arugment passed\n";
             std::cout << "Available options: naive, decomp\n";
             return 1;
         }
     }
-    intermPath = pathTo(lastMissionPoint, path.front(), boundary);
+    profiler().reset(); // Time the run from here
+    profiler().tracing = !config.traceFile.empty();
 
-    // Write output
-    for (std::list<Coord>::iterator it = intermPath.begin(); it != intermPath.end(); ++it)
+    if (!config.socketFile.empty())
     {
-        CoordtoGPS(*it, longitude, latitude);
-	if (i != 1)
-	    outFile << ',';
-        outFile << i << ',' << toDegrees(latitude) << ',' << toDegrees(longitude) << ',' << ALTITUDE;
-        ++i;
+        PlanDaemon daemon(config, naive);
+        return daemon.serve(config.socketFile) ? 0 : 1;
     }
-    for (std::list<Coord>::iterator it = path.begin(); it != path.end(); ++it)
+    bool planned;
+    if (!config.batchFile.empty())
+        planned = runBatch(config, naive);
+    else
     {
-        CoordtoGPS(*it, longitude, latitude);
-	if (i != 1)
-	    outFile << ',';
-        outFile << i << ',' << toDegrees(latitude) << ',' << toDegrees(longitude) << ',' << ALTITUDE;
-        ++i;
+        MissionResult result;
+        planned = planMission(config, naive, result);
+        if (!planned)
+            std::cout << result.error << '\n';
     }
-    outFile.close();
-    return 0;
+    if (!config.profileFile.empty() && !profiler().writeReport(config.profileFile))
+        return 1;
+    if (!config.traceFile.empty() && !profiler().writeTrace(config.traceFile))
+        return 1;
+    return planned ? 0 : 1;
 }
-